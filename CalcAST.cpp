@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <map>
+#include <algorithm>
 
 #include "CalcAST.hpp"
 #include "Token.hpp"
@@ -21,8 +22,8 @@ namespace CalcAST {
 		template <class Num>
 			std::vector<Token> shunting_yard(
 				const std::vector<Token> & tokens) {
-				auto & bin_lookup = CalcOperators<Num>::binary_op_lookup;
-				auto & un_lookup  = CalcOperators<Num>::unary_op_lookup;
+				auto & binary_ops = CalcOperators<Num>::binary_ops;
+				auto & unary_ops  = CalcOperators<Num>::unary_ops;
 
 				/**
 				 * The output stack - basically the RPN this function creates
@@ -60,22 +61,40 @@ namespace CalcAST {
 							op_stack.pop_back();
 						}
 					} else if (tk.type == TK_OPERATOR) {
-						while ((
-							!op_stack.empty() &&
-							(
-								op_stack.back().type != TK_OPAREN && (
-									bin_lookup.at(op_stack.back().data).order >
-									bin_lookup.at(tk.data).order ||
-									(
-										bin_lookup.at(op_stack.back().data)
-										          .order ==
-										bin_lookup.at(tk.data).order &&
-										bin_lookup.at(op_stack.back().data)
-										          .associativity == ASSOCIATE_L
-									)
-								)
-							)
-						)) {
+						const CalcOperator<Num> & op = binary_ops[
+							CalcOperators<Num>::binary_index(tk)];
+
+						while (!op_stack.empty() &&
+						       op_stack.back().type != TK_OPAREN) {
+							const Token & top_tk = op_stack.back();
+
+							/**
+							 * Prefix unary operators still waiting on the
+							 * stack (like the - in -(2)^2) take the
+							 * precedence of the binary operator with the
+							 * same symbol
+							 */
+							int top_op = top_tk.type == TK_OPERATOR
+							             ? static_cast<int>(
+								             CalcOperators<Num>::binary_index(
+									             top_tk))
+							             : CalcOperators<Num>::find_binary(
+								             top_tk.data);
+
+							if (top_op < 0) {
+								throw CalcASTException(top_tk,
+								                       L"Invalid operation");
+							}
+
+							const CalcOperator<Num> & top = binary_ops[top_op];
+
+							if (!(top.order > op.order || (
+								top.order == op.order &&
+								top.associativity == ASSOCIATE_L
+							))) {
+								break;
+							}
+
 							output.push_back(op_stack.back());
 							op_stack.pop_back();
 						}
@@ -85,8 +104,8 @@ namespace CalcAST {
 						/**
 						 * if the operator is expected to come after the number
 						 */
-						if (un_lookup.at(tk.data).associativity
-						    == UASSOCIATE_AFT) {
+						if (unary_ops[CalcOperators<Num>::unary_index(tk)]
+							    .associativity == UASSOCIATE_AFT) {
 							output.push_back(tk);
 						} else {
 							/**
@@ -225,7 +244,8 @@ namespace CalcAST {
 
 	template <class Num>
 		CalcASTElem get_exp_from_rpn(std::vector<Token> & rpn,
-		                             Calculator<Num> & calc) {
+		                             Calculator<Num> & calc,
+		                             std::vector<Num> * constants) {
 			Token last = rpn.back();
 			rpn.pop_back();
 
@@ -236,20 +256,35 @@ namespace CalcAST {
 					                       " operator");
 				}
 
-				return CalcASTElem(AST_UOPERATION, last,
-				                   {get_exp_from_rpn(rpn, calc)});
+				/**
+				 * Children are moved in rather than copied, so building the
+				 * tree never copies a subtree
+				 */
+				CalcASTElem elem(AST_UOPERATION, last);
+				elem.children.push_back(get_exp_from_rpn(rpn, calc, constants));
+
+				return elem;
 			} else if (last.type & (TK_NUMBER | TK_VARIABLE)) {
-				if (last.type == TK_NUMBER) {
+				CalcASTElem elem(AST_VALUE, last);
+
+				if (last.type == TK_NUMBER && constants) {
+					/**
+					 * This is the only place the number is parsed. Everything
+					 * after this just reads it from the pool. Without a pool
+					 * there's nowhere to keep it, so it's parsed later.
+					 */
 					try {
-						Num(LD::w2str(last.data));
+						constants->emplace_back(LD::w2str(last.data));
 					} catch (std::exception & exc) {
 						throw CalcASTException(last, L"Invalid number (" +
 						                             LD::c2wstr(exc.what()) +
 						                             L")");
 					}
+
+					elem.constant = static_cast<long>(constants->size() - 1);
 				}
 
-				return CalcASTElem(AST_VALUE, last);
+				return elem;
 			} else if (last.type == TK_OPERATOR) {
 				/**
 				 * last.type == TK_OPERATOR, since the last `if` statement didn't return
@@ -268,7 +303,7 @@ namespace CalcAST {
 				 *
 				 * Plus operations also expect the LHS and RHS to be in order.
 				 */
-				CalcASTElem right = get_exp_from_rpn(rpn, calc);
+				CalcASTElem right = get_exp_from_rpn(rpn, calc, constants);
 
 				/**
 				 * Do this again because issues can crop up between `right` and
@@ -291,9 +326,14 @@ namespace CalcAST {
 					                       L" operator");
 				}
 
-				CalcASTElem left = get_exp_from_rpn(rpn, calc);
+				CalcASTElem left = get_exp_from_rpn(rpn, calc, constants);
+
+				CalcASTElem elem(AST_OPERATION, last);
+				elem.children.reserve(2);
+				elem.children.push_back(std::move(left));
+				elem.children.push_back(std::move(right));
 
-				return CalcASTElem(AST_OPERATION, last, {left, right});
+				return elem;
 			} else if (last.type == TK_FUNCTION) {
 				if (rpn.empty()) {
 					throw CalcASTException(last, L"Function arity not found");
@@ -306,6 +346,7 @@ namespace CalcAST {
 				rpn.pop_back();
 
 				CalcASTElem func_elem = CalcASTElem(AST_CALL, last);
+				func_elem.children.reserve(arity);
 
 				for (unsigned i = 0; i < arity; i++) {
 					if (rpn.empty()) {
@@ -322,17 +363,18 @@ namespace CalcAST {
 					}
 
 					/**
-					 * insert at the beginning because the shunting yard inserts
-					 * them in the RPN in order... which is a problem because
-					 * RPN is reversed, we're working from the end here
+					 * the shunting yard inserts them in the RPN in order...
+					 * which is a problem because RPN is reversed, we're working
+					 * from the end here
 					 *
-					 * so solve this by inserting at the beginning for every
-					 * element
+					 * so solve this by reversing them once we have them all
 					 */
-					func_elem.children.insert(func_elem.children.begin(),
-					                          get_exp_from_rpn(rpn, calc));
+					func_elem.children.push_back(get_exp_from_rpn(rpn, calc, constants));
 				}
 
+				std::reverse(func_elem.children.begin(),
+				             func_elem.children.end());
+
 				return func_elem;
 			} else {
 				throw CalcASTException(last, L"Unknown token");
@@ -340,7 +382,8 @@ namespace CalcAST {
 		}
 
 	template <class Num>
-		CalcASTElem rpn_to_ast(std::vector<Token> rpn, Calculator<Num> & calc) {
+		CalcASTElem rpn_to_ast(std::vector<Token> rpn, Calculator<Num> & calc,
+		                       std::vector<Num> * constants) {
 			/**
 			 * Nothing to see here, move along
 			 */
@@ -373,7 +416,7 @@ namespace CalcAST {
 			 *           │ └ 5
 			 *           └ 7
 			 */
-			CalcASTElem exp = get_exp_from_rpn(rpn, calc);
+			CalcASTElem exp = get_exp_from_rpn(rpn, calc, constants);
 
 			/**
 			 * This error expresses my confusion perfectly
@@ -390,12 +433,19 @@ namespace CalcAST {
 	 * to generate an RPN token list and then uses [[CalcAST::rpn_to_ast]] to
 	 * generate an AST out of that.
 	 *
+	 * Numbers are parsed into `constants` as they're found, and each number's
+	 * [[CalcASTElem::constant]] is its index in there.
+	 *
 	 * @param tokens
+	 * @param calc
+	 * @param constants The constant pool to add parsed numbers to, if not
+	 * `nullptr`. Otherwise every number's [[CalcASTElem::constant]] stays -1.
 	 * @return
 	 */
 	template <class Num>
 		CalcASTElem generate_ast(const std::vector<Token> & tokens,
-		                         Calculator<Num> & calc) {
+		                         Calculator<Num> & calc,
+		                         std::vector<Num> * constants) {
 			/**
 			 * Get RPN, which [[CalcAST::rpn_to_ast]] parses, from the list of
 			 * tokens
@@ -406,7 +456,7 @@ namespace CalcAST {
 				/**
 				 * Return the AST equivalent of said RPN
 				 */
-				return rpn_to_ast(rpn, calc);
+				return rpn_to_ast(rpn, calc, constants);
 			} catch (std::runtime_error &) {
 				Token tk = tokens.empty() ? Token() : tokens.back();
 
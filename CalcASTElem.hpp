@@ -32,6 +32,14 @@ struct CalcASTElem {
 	 */
 	std::vector<CalcASTElem> children;
 
+	/**
+	 * For numbers, the index of the already-parsed value in the constant pool
+	 * of the expression this element belongs to (see
+	 * [[CalcAST::generate_ast]]). -1 if the number hasn't been parsed, i.e.
+	 * the AST was put together by hand.
+	 */
+	long constant = -1;
+
 	/**
 	 * Create a new [[CalcASTElem]].
 	 *
@@ -27,7 +27,38 @@ enum {
 	/**
 	 * A call to a function. Can have a variable amount of children.
 	 */
-	AST_CALL
+	AST_CALL,
+
+	/**
+	 * A subtree that [[CalcFold::fold]] evaluated ahead of time. Its token is
+	 * a TK_NUMBER spanning the whole subtree, and its value is in the
+	 * constant pool at [[CalcASTElem::constant]].
+	 *
+	 * Must have zero children.
+	 */
+	AST_CONSTANT,
+
+	/**
+	 * A chain of additions and subtractions, like `a + b - c`, that
+	 * [[CalcFlatten::flatten]] turned into one element. Its token is the first
+	 * operator in the chain.
+	 *
+	 * The first child is the first operand. Every other child is an
+	 * [[AST_TERM]] with the operand that comes after it.
+	 */
+	AST_SUM,
+
+	/**
+	 * Same as [[AST_SUM]], but for multiplications and divisions.
+	 */
+	AST_PRODUCT,
+
+	/**
+	 * An operand of an [[AST_SUM]] or [[AST_PRODUCT]], other than the first.
+	 * Its token is the operator in front of the operand, and its only child
+	 * is the operand.
+	 */
+	AST_TERM
 };
 
 /**
@@ -36,7 +67,12 @@ enum {
 std::map<int, std::wstring> calc_debug_ast {
 	{AST_VALUE, L"VALUE"},
 	{AST_OPERATION, L"OPERATION"},
-	{AST_UOPERATION, L"UOPERATION"}
+	{AST_UOPERATION, L"UOPERATION"},
+	{AST_CALL, L"CALL"},
+	{AST_CONSTANT, L"CONSTANT"},
+	{AST_SUM, L"SUM"},
+	{AST_PRODUCT, L"PRODUCT"},
+	{AST_TERM, L"TERM"}
 };
 
 #endif //CALCULATOR_CALCASTENUM_HPP
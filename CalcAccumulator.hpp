@@ -0,0 +1,111 @@
+#ifndef CALCULATOR_CALCACCUMULATOR_HPP
+#define CALCULATOR_CALCACCUMULATOR_HPP
+
+#include "HybridRational.hpp"
+#include "Multiplication.hpp"
+
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * Works out a sum or a product of rationals without putting anything in
+ * lowest terms until the end. Used by [[CalcOperations::NaryKernels]].
+ *
+ * The numerator and denominator are kept as separate integers. Adding
+ * something with the same denominator (which includes adding integers) is a
+ * single addition, anything else is cross multiplied. Multiplying multiplies
+ * the numerators and denominators separately. [[CalcAccumulator::get]] does
+ * the only GCD, instead of there being one for every operation.
+ *
+ * @tparam Num [[math::Rational]], or anything with the same `numerator()`
+ * and `denominator()` that can be made from one
+ */
+template <class Num>
+	class CalcAccumulator {
+		math::Integer num;
+		math::Integer den;
+
+		public:
+		explicit CalcAccumulator(const Num & first)
+			: num(first.numerator()), den(first.denominator()) {}
+
+		/**
+		 * Adds `value`, or subtracts it if `subtract` is true
+		 */
+		void add(const Num & value, bool subtract) {
+			math::Integer value_num = value.numerator();
+			math::Integer value_den = value.denominator();
+
+			if (subtract) {
+				value_num = -value_num;
+			}
+
+			if (value_den == den) {
+				num += value_num;
+			} else {
+				num = Multiplication::multiply(num, value_den) +
+				      Multiplication::multiply(value_num, den);
+				den = Multiplication::multiply(den, value_den);
+			}
+		}
+
+		/**
+		 * Multiplies by `value`, or divides by it if `divide` is true. It
+		 * can't be 0 if it's being divided by.
+		 */
+		void multiply(const Num & value, bool divide) {
+			if (divide) {
+				num = Multiplication::multiply(num, value.denominator());
+				den = Multiplication::multiply(den, value.numerator());
+			} else {
+				num = Multiplication::multiply(num, value.numerator());
+				den = Multiplication::multiply(den, value.denominator());
+			}
+		}
+
+		/**
+		 * @return The result, in lowest terms
+		 */
+		Num get() const {
+			if (den < 0) {
+				return math::Rational(-num, -den);
+			}
+
+			return math::Rational(num, den);
+		}
+	};
+
+/**
+ * Small [[HybridRational]]s are put in lowest terms with a machine word GCD,
+ * which costs less than turning them into integers, so this just does the
+ * operations one at a time.
+ */
+template <>
+	class CalcAccumulator<HybridRational> {
+		HybridRational value;
+
+		public:
+		explicit CalcAccumulator(const HybridRational & first)
+			: value(first) {}
+
+		void add(const HybridRational & operand, bool subtract) {
+			if (subtract) {
+				value -= operand;
+			} else {
+				value += operand;
+			}
+		}
+
+		void multiply(const HybridRational & operand, bool divide) {
+			if (divide) {
+				value /= operand;
+			} else {
+				value *= operand;
+			}
+		}
+
+		HybridRational get() const {
+			return value;
+		}
+	};
+
+#endif //CALCULATOR_CALCACCUMULATOR_HPP
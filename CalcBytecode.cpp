@@ -0,0 +1,298 @@
+#ifndef CALCULATOR_CALCBYTECODE_CPP
+#define CALCULATOR_CALCBYTECODE_CPP
+
+#include <string>
+#include <vector>
+
+#include "CalcBytecode.hpp"
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcASTEnum.hpp"
+#include "CalcFlatten.hpp"
+#include "CalcASTException.hpp"
+#include "CalcResult.hpp"
+#include "CalcProgram.hpp"
+#include "CalcOperators.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+
+/**
+ * Namespace for turning ASTs into [[CalcProgram]]s
+ */
+namespace CalcBytecode {
+	namespace {
+		/**
+		 * Appends one instruction and its error token to `program`.
+		 */
+		template <class Num>
+			void emit(CalcProgram<Num> & program, CalcOpcode op, unsigned arg,
+			          const Token & span) {
+				program.code.emplace_back(op, arg);
+				program.spans.push_back(span);
+			}
+
+		/**
+		 * Records that a value is pushed while `depth` values are already on
+		 * the stack.
+		 */
+		template <class Num>
+			void push(CalcProgram<Num> & program, unsigned long depth) {
+				if (depth + 1 > program.max_stack) {
+					program.max_stack = depth + 1;
+				}
+			}
+
+		template <class Num>
+			CalcResult<bool> check_calls(const CalcASTElem & ast,
+			                             Calculator<Num> & calc) {
+				if (ast.token.type == TK_FUNCTION &&
+				    !calc.find_function(ast.token.data, static_cast<unsigned>(
+					    ast.children.size()))) {
+					return CalcError(calc.get_token(ast),
+					                 L"Invalid function call");
+				}
+
+				for (const CalcASTElem & child : ast.children) {
+					CalcResult<bool> result = check_calls(child, calc);
+
+					if (!result.ok()) {
+						return result;
+					}
+				}
+
+				return true;
+			}
+
+		template <class Num>
+			CalcResult<Token> compile_elem(const CalcASTElem & ast,
+			                               Calculator<Num> & calc,
+			                               CalcProgram<Num> & program,
+			                               unsigned long pool_size,
+			                               unsigned long depth) {
+				if (ast.type == AST_SUM || ast.type == AST_PRODUCT) {
+					std::vector<bool> inverse;
+					Token             span = ast.token;
+
+					for (unsigned long i = 0; i < ast.children.size(); i++) {
+						CalcResult<Token> operand_span = compile_elem(
+							CalcFlatten::operand(ast, i), calc, program,
+							pool_size, depth + i);
+
+						if (!operand_span.ok()) {
+							return operand_span;
+						}
+
+						inverse.push_back(CalcFlatten::inverse(ast, i));
+
+						if (inverse.back() && ast.type == AST_PRODUCT) {
+							emit(program, OP_DIVISOR, 0, operand_span.get());
+						}
+
+						span = calc.join_tokens(span, ast.children[i].token);
+						span = calc.join_tokens(span, operand_span.get());
+					}
+
+					program.chains.push_back(std::move(inverse));
+
+					emit(program, ast.type == AST_SUM ? OP_SUM : OP_PRODUCT,
+					     static_cast<unsigned>(program.chains.size() - 1),
+					     span);
+
+					span.type = TK_UNKNOWN;
+
+					return span;
+				} else if (ast.token.type == TK_NUMBER) {
+					/**
+					 * The constant pool passed to [[CalcBytecode::compile]]
+					 * already has the numbers that were parsed while building
+					 * the AST
+					 */
+					if (ast.constant >= 0 &&
+					    static_cast<unsigned long>(ast.constant) < pool_size) {
+						push(program, depth);
+						emit(program, OP_CONST,
+						     static_cast<unsigned>(ast.constant), ast.token);
+
+						return ast.token;
+					}
+
+					/**
+					 * Otherwise, parse the number once, here, instead of every
+					 * time the program is run. The number type throws if it
+					 * doesn't like the number, there's no way around that.
+					 */
+					try {
+						program.constants.emplace_back(
+							LD::w2str(ast.token.data));
+					} catch (std::exception & e) {
+						return CalcError(ast.token,
+						                 L"Invalid number (" +
+						                 LD::c2wstr(e.what()) + L")");
+					}
+
+					push(program, depth);
+					emit(program, OP_CONST, static_cast<unsigned>(
+						program.constants.size() - 1), ast.token);
+
+					return ast.token;
+				} else if (ast.token.type == TK_VARIABLE) {
+					push(program, depth);
+					emit(program, OP_LOAD,
+					     calc.variables.intern(ast.token.data), ast.token);
+
+					return ast.token;
+				} else if (ast.token.type == TK_OPERATOR) {
+					const CalcASTElem & lhs = ast.children[0];
+					const CalcASTElem & rhs = ast.children[1];
+
+					/**
+					 * Assignment doesn't evaluate its left hand side, so it
+					 * doesn't have a kernel. It gets its own instruction
+					 * instead.
+					 */
+					if (ast.token.data == L"=") {
+						/**
+						 * 3 = 3.141592653589793
+						 *
+						 * I don't think so
+						 */
+						if (lhs.token.type != TK_VARIABLE) {
+							return CalcError(calc.get_token(lhs),
+							                 L"Can't assign to non-variable");
+						} else if (lhs.token.data == L"_") {
+							return CalcError(calc.get_token(lhs),
+							                 L"Assignment will be overwritten");
+						}
+
+						CalcResult<Token> rhs_span = compile_elem(
+							rhs, calc, program, pool_size, depth);
+
+						if (!rhs_span.ok()) {
+							return rhs_span;
+						}
+
+						emit(program, OP_STORE,
+						     calc.variables.intern(lhs.token.data), lhs.token);
+
+						Token span = calc.join_tokens(
+							calc.join_tokens(ast.token, lhs.token),
+							rhs_span.get());
+						span.type = TK_UNKNOWN;
+
+						return span;
+					}
+
+					int op = CalcOperators<Num>::find_binary(ast.token);
+
+					if (op < 0 || !CalcOperators<Num>::binary_ops[op].kernel) {
+						return CalcError(ast.token, L"Invalid operation");
+					}
+
+					CalcResult<Token> lhs_span = compile_elem(
+						lhs, calc, program, pool_size, depth);
+
+					if (!lhs_span.ok()) {
+						return lhs_span;
+					}
+
+					CalcResult<Token> rhs_span = compile_elem(
+						rhs, calc, program, pool_size, depth + 1);
+
+					if (!rhs_span.ok()) {
+						return rhs_span;
+					}
+
+					/**
+					 * Binary operators only ever complain about their right
+					 * hand side (dividing by 0, invalid powers)
+					 */
+					emit(program, OP_BINARY, static_cast<unsigned>(op),
+					     rhs_span.get());
+
+					Token span = calc.join_tokens(
+						calc.join_tokens(ast.token, lhs_span.get()),
+						rhs_span.get());
+					span.type = TK_UNKNOWN;
+
+					return span;
+				} else if (ast.token.type == TK_UOPERATOR) {
+					int op = CalcOperators<Num>::find_unary(ast.token);
+
+					if (op < 0) {
+						return CalcError(ast.token, L"Invalid operation");
+					}
+
+					CalcResult<Token> num_span = compile_elem(
+						ast.children[0], calc, program, pool_size, depth);
+
+					if (!num_span.ok()) {
+						return num_span;
+					}
+
+					emit(program, OP_UNARY, static_cast<unsigned>(op),
+					     num_span.get());
+
+					Token span = calc.join_tokens(ast.token, num_span.get());
+					span.type = TK_UNKNOWN;
+
+					return span;
+				} else if (ast.token.type == TK_FUNCTION) {
+					/**
+					 * Functions want their AST element, so just hand it over
+					 * as-is when the time comes
+					 */
+					Token span = calc.get_token(ast);
+
+					CalcResult<bool> checked = check_calls(ast, calc);
+
+					if (!checked.ok()) {
+						return checked.get_error();
+					}
+
+					program.calls.push_back(ast);
+
+					push(program, depth);
+					emit(program, OP_CALL, static_cast<unsigned>(
+						program.calls.size() - 1), span);
+
+					return span;
+				} else {
+					return CalcError(ast.token, L"Unknown AST element");
+				}
+			}
+	}
+
+	template <class Num>
+		CalcResult<CalcProgram<Num>> try_compile(const CalcASTElem & ast,
+		                                         Calculator<Num> & calc,
+		                                         std::vector<Num> constants) {
+			CalcProgram<Num> program;
+
+			program.constants = std::move(constants);
+
+			CalcResult<Token> compiled = compile_elem(
+				ast, calc, program, program.constants.size(), 0);
+
+			if (!compiled.ok()) {
+				return compiled.get_error();
+			}
+
+			CalcResult<bool> bound = calc.try_bind(program);
+
+			if (!bound.ok()) {
+				return bound.get_error();
+			}
+
+			return program;
+		}
+
+	template <class Num>
+		CalcProgram<Num> compile(const CalcASTElem & ast,
+		                         Calculator<Num> & calc,
+		                         std::vector<Num> constants) {
+			return std::move(
+				try_compile(ast, calc, std::move(constants)).get());
+		}
+}
+
+#endif //CALCULATOR_CALCBYTECODE_CPP
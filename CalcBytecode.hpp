@@ -0,0 +1,83 @@
+#ifndef CALCULATOR_CALCBYTECODE_HPP
+#define CALCULATOR_CALCBYTECODE_HPP
+
+#include <string>
+
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcProgram.hpp"
+#include "CalcResult.hpp"
+
+/**
+ * Namespace for turning ASTs into [[CalcProgram]]s
+ */
+namespace CalcBytecode {
+	namespace {
+		/**
+		 * Makes sure every function called by `ast` (which is a call) and
+		 * its arguments exists, so unknown functions are reported when the
+		 * expression is compiled instead of when it's run.
+		 */
+		template <class Num>
+			CalcResult<bool> check_calls(const CalcASTElem & ast,
+			                             Calculator<Num> & calc);
+
+		/**
+		 * Compiles one AST element (and all of its children) onto the end of
+		 * `program`, in evaluation order.
+		 *
+		 * @param ast The AST element to compile
+		 * @param calc The calculator, used for tokens and error reporting
+		 * @param program The program to append to
+		 * @param pool_size How many constants were given to
+		 * [[CalcBytecode::compile]]. Numbers that point into those are
+		 * already parsed.
+		 * @param depth How many values are on the stack before this element
+		 * @return The token that [[Calculator::get_token]] would return for
+		 * `ast`, so errors can point at whole subexpressions, or the error
+		 */
+		template <class Num>
+			CalcResult<Token> compile_elem(const CalcASTElem & ast,
+			                               Calculator<Num> & calc,
+			                               CalcProgram<Num> & program,
+			                               unsigned long pool_size,
+			                               unsigned long depth);
+	}
+
+	/**
+	 * Compiles an AST from i.e. [[Calculator::get_ast]] into a flat program
+	 * that [[Calculator::execute_program]] can run without recursion.
+	 *
+	 * Number literals are parsed here (unless they're already in `constants`,
+	 * see [[CalcAST::generate_ast]]), and operators are looked up here, so
+	 * none of that has to happen again no matter how many times the program
+	 * is run. Errors that can be found without evaluating anything (invalid
+	 * numbers, invalid operators, assigning to non-variables, unknown
+	 * functions) are thrown here as [[CalcASTException]]s.
+	 *
+	 * Function calls are bound to `calc`'s functions, see
+	 * [[Calculator::bind]].
+	 *
+	 * @param ast The AST to compile
+	 * @param calc The calculator the program will be run by. Variables are
+	 * given slots in its [[Calculator::variables]].
+	 * @param constants The constant pool the AST's numbers point into. It
+	 * becomes the program's [[CalcProgram::constants]].
+	 * @return The compiled program
+	 */
+	template <class Num>
+		CalcProgram<Num> compile(const CalcASTElem & ast,
+		                         Calculator<Num> & calc,
+		                         std::vector<Num> constants = {});
+
+	/**
+	 * Same as [[CalcBytecode::compile]], but returns errors instead of
+	 * throwing them.
+	 */
+	template <class Num>
+		CalcResult<CalcProgram<Num>> try_compile(
+			const CalcASTElem & ast, Calculator<Num> & calc,
+			std::vector<Num> constants = {});
+}
+
+#endif //CALCULATOR_CALCBYTECODE_HPP
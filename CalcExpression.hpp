@@ -0,0 +1,55 @@
+#ifndef CALCULATOR_CALCEXPRESSION_HPP
+#define CALCULATOR_CALCEXPRESSION_HPP
+
+#include <vector>
+
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcASTEnum.hpp"
+#include "CalcProgram.hpp"
+
+/**
+ * An expression that has been tokenized, parsed and compiled, and is ready to
+ * be evaluated any number of times. This is what
+ * [[Calculator::expression_cache]] stores.
+ */
+template <class Num>
+	struct CalcExpression {
+		/**
+		 * The tokens, as the user typed them
+		 */
+		std::vector<Token> tokens;
+
+		/**
+		 * The AST from [[Calculator::get_ast]]
+		 */
+		CalcASTElem ast;
+
+		/**
+		 * [[CalcExpression::ast]] after [[CalcFold::fold]], if
+		 * [[CalcExpression::folded]]
+		 */
+		CalcASTElem folded_ast;
+
+		/**
+		 * Whether [[Calculator::fold]] has been run on this expression
+		 */
+		bool folded = false;
+
+		/**
+		 * The compiled AST from [[Calculator::compile]]. Once the expression
+		 * has been folded, this is compiled from the folded AST instead.
+		 */
+		CalcProgram<Num> program;
+
+		/**
+		 * Whether [[Calculator::get_ast]] used the last result implicitly
+		 * (i.e. "* 5" -> "_ * 5"), which only works while there is one
+		 */
+		bool implicit_last = false;
+
+		CalcExpression()
+			: ast(AST_VALUE, Token()), folded_ast(AST_VALUE, Token()) {}
+	};
+
+#endif //CALCULATOR_CALCEXPRESSION_HPP
@@ -0,0 +1,89 @@
+#ifndef CALCULATOR_CALCFLATTEN_CPP
+#define CALCULATOR_CALCFLATTEN_CPP
+
+#include <utility>
+
+#include "CalcFlatten.hpp"
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcASTEnum.hpp"
+
+/**
+ * Namespace for flattening, which is an optimization pass that runs after
+ * [[CalcFold::fold]]
+ */
+namespace CalcFlatten {
+	namespace {
+		int chain_type(const CalcASTElem & ast) {
+			if (ast.type == AST_SUM || ast.type == AST_PRODUCT) {
+				return ast.type;
+			} else if (ast.type != AST_OPERATION ||
+			           ast.token.type != TK_OPERATOR ||
+			           ast.children.size() != 2) {
+				return -1;
+			}
+
+			if (ast.token.data == L"+" || ast.token.data == L"-") {
+				return AST_SUM;
+			} else if (ast.token.data == L"*" || ast.token.data == L"/") {
+				return AST_PRODUCT;
+			}
+
+			return -1;
+		}
+
+		void flatten_elem(CalcASTElem & ast) {
+			for (CalcASTElem & child : ast.children) {
+				flatten_elem(child);
+			}
+
+			int type = chain_type(ast);
+
+			if (type < 0 || ast.type != AST_OPERATION ||
+			    chain_type(ast.children[0]) != type) {
+				return;
+			}
+
+			CalcASTElem & lhs = ast.children[0];
+			CalcASTElem   term(AST_TERM, ast.token,
+			                   {std::move(ast.children[1])});
+			CalcASTElem   chain(type, lhs.token);
+
+			if (lhs.type == type) {
+				/**
+				 * Already a chain, just add to the end
+				 */
+				chain = std::move(lhs);
+			} else {
+				/**
+				 * Two operands on the left and one more here, so this is
+				 * where the chain starts
+				 */
+				chain.children.push_back(std::move(lhs.children[0]));
+				chain.children.emplace_back(
+					AST_TERM, lhs.token,
+					std::vector<CalcASTElem> {std::move(lhs.children[1])});
+			}
+
+			chain.children.push_back(std::move(term));
+			ast = std::move(chain);
+		}
+	}
+
+	CalcASTElem flatten(CalcASTElem ast) {
+		flatten_elem(ast);
+
+		return ast;
+	}
+
+	const CalcASTElem & operand(const CalcASTElem & chain, unsigned long i) {
+		return i == 0 ? chain.children[0] : chain.children[i].children[0];
+	}
+
+	bool inverse(const CalcASTElem & chain, unsigned long i) {
+		return i > 0 && (chain.children[i].token.data == L"-" ||
+		                 chain.children[i].token.data == L"/");
+	}
+}
+
+#endif //CALCULATOR_CALCFLATTEN_CPP
@@ -0,0 +1,61 @@
+#ifndef CALCULATOR_CALCFLATTEN_HPP
+#define CALCULATOR_CALCFLATTEN_HPP
+
+#include "CalcASTElem.hpp"
+
+/**
+ * Namespace for flattening, which is an optimization pass that runs after
+ * [[CalcFold::fold]]
+ */
+namespace CalcFlatten {
+	namespace {
+		/**
+		 * @return [[AST_SUM]] if `ast` is `+`, `-` or a sum, [[AST_PRODUCT]]
+		 * if it's `*`, `/` or a product, -1 if it's neither
+		 */
+		int chain_type(const CalcASTElem & ast);
+
+		/**
+		 * Flattens `ast` in place, children first.
+		 */
+		void flatten_elem(CalcASTElem & ast);
+	}
+
+	/**
+	 * Turns chains of `+` and `-`, like `a + b - c + d`, into a single
+	 * [[AST_SUM]], and chains of `*` and `/` into a single [[AST_PRODUCT]].
+	 *
+	 * The parser makes chains like those into a tree of binary operations,
+	 * ((a + b) - c) + d, and every one of those operations produces a number
+	 * in lowest terms. With everything in one place, the whole chain can be
+	 * worked out over a common denominator and put in lowest terms once (see
+	 * [[CalcOperations::NaryKernels]]).
+	 *
+	 * Only left hand sides are pulled into a chain, since that's the order
+	 * the operations would've happened in anyway. `a - (b + c)` is a chain of
+	 * two, which is left alone, with a chain of two inside it, also left
+	 * alone. The operands are evaluated in the same order as before, and
+	 * the operators stay in the AST, so errors are the same and point at the
+	 * same place.
+	 *
+	 * @param ast The AST to flatten
+	 * @return The flattened AST
+	 */
+	CalcASTElem flatten(CalcASTElem ast);
+
+	/**
+	 * @param chain An [[AST_SUM]] or [[AST_PRODUCT]]
+	 * @param i Which operand
+	 * @return The operand
+	 */
+	const CalcASTElem & operand(const CalcASTElem & chain, unsigned long i);
+
+	/**
+	 * @param chain An [[AST_SUM]] or [[AST_PRODUCT]]
+	 * @param i Which operand
+	 * @return Whether the operand is subtracted or divided by
+	 */
+	bool inverse(const CalcASTElem & chain, unsigned long i);
+}
+
+#endif //CALCULATOR_CALCFLATTEN_HPP
@@ -0,0 +1,88 @@
+#ifndef CALCULATOR_CALCFOLD_CPP
+#define CALCULATOR_CALCFOLD_CPP
+
+#include <vector>
+#include <exception>
+
+#include "CalcFold.hpp"
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcASTEnum.hpp"
+
+/**
+ * Namespace for constant folding, which is an optimization pass that runs
+ * between [[CalcAST::generate_ast]] and [[CalcBytecode::compile]]
+ */
+namespace CalcFold {
+	namespace {
+		template <class Num>
+			bool fold_elem(CalcASTElem & ast, Calculator<Num> & calc,
+			               std::vector<Num> & constants) {
+				if (ast.token.type == TK_NUMBER) {
+					return true;
+				} else if (ast.token.type == TK_VARIABLE) {
+					return false;
+				}
+
+				/**
+				 * Fold every child, even if one of them turns out not to be
+				 * constant, so that `x * (2 + 3)` still becomes `x * 5`
+				 */
+				bool constant = true;
+
+				for (CalcASTElem & child : ast.children) {
+					constant = fold_elem(child, calc, constants) && constant;
+				}
+
+				if (!constant) {
+					return false;
+				}
+
+				if (ast.token.type == TK_OPERATOR && ast.token.data == L"=") {
+					/**
+					 * Assignments have side effects, and the left hand side
+					 * can't be constant anyway
+					 */
+					return false;
+				} else if (ast.token.type == TK_FUNCTION &&
+				           !calc.pure_funcs.count(ast.token.data)) {
+					/**
+					 * Who knows what this function does
+					 */
+					return false;
+				} else if (!(ast.token.type &
+				             (TK_OPERATOR | TK_UOPERATOR | TK_FUNCTION))) {
+					return false;
+				}
+
+				/**
+				 * If this fails, leave it for the program to fail on. That
+				 * way the error is reported just like it would've been
+				 * without folding.
+				 */
+				try {
+					constants.push_back(calc.execute_ast(ast, constants));
+				} catch (std::exception &) {
+					return false;
+				}
+
+				Token span = calc.get_token(ast);
+				span.type = TK_NUMBER;
+
+				ast = CalcASTElem(AST_CONSTANT, span);
+				ast.constant = static_cast<long>(constants.size() - 1);
+
+				return true;
+			}
+	}
+
+	template <class Num>
+		CalcASTElem fold(CalcASTElem ast, Calculator<Num> & calc,
+		                 std::vector<Num> & constants) {
+			fold_elem(ast, calc, constants);
+
+			return ast;
+		}
+}
+
+#endif //CALCULATOR_CALCFOLD_CPP
@@ -0,0 +1,53 @@
+#ifndef CALCULATOR_CALCFOLD_HPP
+#define CALCULATOR_CALCFOLD_HPP
+
+#include <vector>
+
+#include "CalcASTElem.hpp"
+
+template <class Num>
+	class Calculator;
+
+/**
+ * Namespace for constant folding, which is an optimization pass that runs
+ * between [[CalcAST::generate_ast]] and [[CalcBytecode::compile]]
+ */
+namespace CalcFold {
+	namespace {
+		/**
+		 * Folds `ast` in place. Children are folded first, so the deepest
+		 * constant subtrees are folded even if something above them can't be.
+		 *
+		 * @param ast The AST element to fold
+		 * @param calc The calculator, used to evaluate constant subtrees
+		 * @param constants The constant pool, which folded values are added to
+		 * @return Whether `ast` is a constant now
+		 */
+		template <class Num>
+			bool fold_elem(CalcASTElem & ast, Calculator<Num> & calc,
+			               std::vector<Num> & constants);
+	}
+
+	/**
+	 * Replaces every subtree that doesn't depend on variables with a single
+	 * [[AST_CONSTANT]] element holding its value. Numbers, operators (except
+	 * assignment) and calls to functions in [[Calculator::pure_funcs]] can be
+	 * folded. Anything that mentions a variable, including `_`, is left alone.
+	 *
+	 * The folded element's token spans the whole subtree it replaced, so
+	 * errors still point at the same place. If evaluating a subtree fails
+	 * (dividing by 0, for example), it isn't folded, and the error happens
+	 * when the expression is run, just like it would have without folding.
+	 *
+	 * @param ast The AST to fold
+	 * @param calc The calculator the AST will be run by
+	 * @param constants The constant pool the AST's numbers point into. Folded
+	 * values are added to the end.
+	 * @return The folded AST
+	 */
+	template <class Num>
+		CalcASTElem fold(CalcASTElem ast, Calculator<Num> & calc,
+		                 std::vector<Num> & constants);
+}
+
+#endif //CALCULATOR_CALCFOLD_HPP
@@ -9,7 +9,7 @@
 #define RETURN_IF(x) if (x) return last_result
 
 template <class Calc>
-	std::wstring input_loop(Calc calc) {
+	std::wstring input_loop(Calc & calc) {
 		/**
 		 * Simply a variable re-used multiple times to store what the user inputs
 		 */
@@ -6,6 +6,33 @@
 #include "Calculator.hpp"
 #include "CalcASTElem.hpp"
 
-#define CalcOpFunc(Num) std::function<Num(Calculator<Num> *, CalcASTElem, bool)>
+template <class Num>
+	class Calculator;
+
+/**
+ * Operators and functions get a reference to their AST element. It's only
+ * valid for the duration of the call, so don't hold on to it.
+ */
+#define CalcOpFunc(Num) std::function<Num(Calculator<Num> *, const CalcASTElem &, bool)>
+
+/**
+ * A binary kernel works on values that have already been evaluated, instead of
+ * on an AST element. The result is written back into `lhs`.
+ *
+ * Returns `nullptr` on success, or a user-friendly error message. The caller
+ * knows which token the error belongs to, the kernel doesn't.
+ */
+template <class Num>
+	using CalcBinaryKernel = const wchar_t * (*)(Calculator<Num> * calc,
+	                                             Num & lhs, const Num & rhs,
+	                                             bool validate_only);
+
+/**
+ * Same as [[CalcBinaryKernel]], but for unary operators. The result is written
+ * back into `num`.
+ */
+template <class Num>
+	using CalcUnaryKernel = const wchar_t * (*)(Calculator<Num> * calc,
+	                                            Num & num, bool validate_only);
 
 #endif //CALCULATOR_CALCOPFUNC_HPP
@@ -1,128 +1,129 @@
 #ifndef CALCULATOR_CALCOPERATIONS_CPP
 #define CALCULATOR_CALCOPERATIONS_CPP
 
+#include <new>
+#include <vector>
+#include <cstdint>
+
 #include "CalcOperations.hpp"
 #include "Calculator.hpp"
 #include "CalcASTElem.hpp"
 #include "CalcASTEnum.hpp"
 #include "CalcASTException.hpp"
+#include "CalcFlatten.hpp"
+#include "CalcAccumulator.hpp"
+#include "IntegerMath.hpp"
+#include "Multiplication.hpp"
 
 #include "boilerplate/ld_boilerplate.hpp"
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::exponentiation(Calculator<Num> * calc,
-	                                                CalcASTElem src,
+	                                                const CalcASTElem & src,
 	                                                bool validate_only) {
-		CalcASTElem lhs       = src.children[0];
-		CalcASTElem rhs       = src.children[1];
-		Num         rhs_final = calc->execute_ast(rhs, validate_only);
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
+
+		Num rhs_final = calc->execute_ast(rhs, validate_only);
 
 		/**
 		 * Easy way out, just return 1. Anything to the power of 0 is
-		 * always 1.
+		 * always 1, so don't even bother with the left hand side.
 		 */
-		if (rhs_final == 0) {
-			if (validate_only) {
-				calc->execute_ast(lhs, validate_only);
-			}
-
+		if (rhs_final == 0 && !validate_only) {
 			return 1;
 		}
 
-		/**
-		 * Fractional exponents may not be rational, and our
-		 * arbitrary-precision types can only represent rational numbers
-		 */
-		if (!calc->is_int(rhs_final) || rhs_final < 0) {
-			throw CalcASTException(calc->get_token(rhs),
-			                       L"Powers must be a positive integer");
-		}
+		Num lhs_final = calc->execute_ast(lhs, validate_only);
 
-		if (validate_only) {
-			return calc->execute_ast(lhs, validate_only);
-		}
+		const wchar_t * error = BinaryKernels::exponentiation(
+			calc, lhs_final, rhs_final, validate_only);
 
-		Num lhs_final = calc->execute_ast(lhs);
+		if (error) {
+			throw CalcASTException(calc->get_token(rhs), error);
+		}
 
-		return math::Rational(
-			LD::ipow(lhs_final.numerator(), rhs_final.numerator()),
-			LD::ipow(lhs_final.denominator(), rhs_final.numerator()));
+		return lhs_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::multiplication(Calculator<Num> * calc,
-	                                                CalcASTElem src,
+	                                                const CalcASTElem & src,
 	                                                bool validate_only) {
-		CalcASTElem lhs = src.children[0];
-		CalcASTElem rhs = src.children[1];
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
 
-		if (validate_only) {
-			calc->execute_ast(lhs, validate_only);
+		Num lhs_final = calc->execute_ast(lhs, validate_only);
 
-			return calc->execute_ast(rhs, validate_only);
-		}
+		BinaryKernels::multiplication(calc, lhs_final,
+		                              calc->execute_ast(rhs, validate_only),
+		                              validate_only);
 
-		return calc->execute_ast(lhs) * calc->execute_ast(rhs);
+		return lhs_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::division(Calculator<Num> * calc,
-	                                          CalcASTElem src,
+	                                          const CalcASTElem & src,
 	                                          bool validate_only) {
-		CalcASTElem lhs       = src.children[0];
-		CalcASTElem rhs       = src.children[1];
-		Num         rhs_final = calc->execute_ast(rhs, validate_only);
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
+
+		Num rhs_final = calc->execute_ast(rhs, validate_only);
 
+		/**
+		 * Check the divisor before evaluating the left hand side, dividing
+		 * by 0 makes the left hand side irrelevant
+		 */
 		if (rhs_final == 0) {
-			throw CalcASTException(calc->get_token(src.children[1]),
-			                       L"Can't divide by 0");
+			throw CalcASTException(calc->get_token(rhs), L"Can't divide by 0");
 		}
 
-		if (validate_only) {
-			return calc->execute_ast(lhs, validate_only);
-		}
+		Num lhs_final = calc->execute_ast(lhs, validate_only);
+
+		BinaryKernels::division(calc, lhs_final, rhs_final, validate_only);
 
-		return calc->execute_ast(lhs) / rhs_final;
+		return lhs_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::addition(Calculator<Num> * calc,
-	                                          CalcASTElem src,
+	                                          const CalcASTElem & src,
 	                                          bool validate_only) {
-		CalcASTElem lhs = src.children[0];
-		CalcASTElem rhs = src.children[1];
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
 
-		if (validate_only) {
-			calc->execute_ast(lhs, validate_only);
+		Num lhs_final = calc->execute_ast(lhs, validate_only);
 
-			return calc->execute_ast(rhs, validate_only);
-		}
+		BinaryKernels::addition(calc, lhs_final,
+		                        calc->execute_ast(rhs, validate_only),
+		                        validate_only);
 
-		return calc->execute_ast(lhs) + calc->execute_ast(rhs);
+		return lhs_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::subtraction(Calculator<Num> * calc,
-	                                             CalcASTElem src,
+	                                             const CalcASTElem & src,
 	                                             bool validate_only) {
-		CalcASTElem lhs = src.children[0];
-		CalcASTElem rhs = src.children[1];
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
 
-		if (validate_only) {
-			calc->execute_ast(lhs, validate_only);
+		Num lhs_final = calc->execute_ast(lhs, validate_only);
 
-			return calc->execute_ast(rhs, validate_only);
-		}
+		BinaryKernels::subtraction(calc, lhs_final,
+		                           calc->execute_ast(rhs, validate_only),
+		                           validate_only);
 
-		return calc->execute_ast(lhs) - calc->execute_ast(rhs);
+		return lhs_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Binary::assignment(Calculator<Num> * calc,
-	                                            CalcASTElem src,
+	                                            const CalcASTElem & src,
 	                                            bool validate_only) {
-		CalcASTElem lhs = src.children[0];
-		CalcASTElem rhs = src.children[1];
+		const CalcASTElem & lhs = src.children[0];
+		const CalcASTElem & rhs = src.children[1];
 
 		/**
 		 * 3 = 3.141592653589793
@@ -144,102 +145,377 @@ template <class Num>
 
 template <class Num>
 	Num CalcOperations<Num>::Unary::factorial(Calculator<Num> * calc,
-	                                          CalcASTElem src,
+	                                          const CalcASTElem & src,
 	                                          bool validate_only) {
-		CalcASTElem num       = src.children[0];
-		Num         num_final = calc->execute_ast(num, validate_only);
-
-		if (!calc->is_int(num_final)) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate factorial of non-integer");
-		} else if (num_final < 0) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate factorial of negative"
-			                       L" integer");
-		}
+		const CalcASTElem & num = src.children[0];
 
-		if (validate_only) return 1;
+		Num num_final = calc->execute_ast(num, validate_only);
 
-		Num factored = 1;
+		const wchar_t * error = UnaryKernels::factorial(calc, num_final,
+		                                                validate_only);
 
-		for (Num i(1); i <= num_final; i++) {
-			factored *= i;
+		if (error) {
+			throw CalcASTException(calc->get_token(num), error);
 		}
 
-		return factored;
+		return num_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Unary::dbl_factorial(Calculator<Num> * calc,
-	                                              CalcASTElem src,
+	                                              const CalcASTElem & src,
 	                                              bool validate_only) {
-		CalcASTElem num       = src.children[0];
-		Num         num_final = calc->execute_ast(num, validate_only);
+		const CalcASTElem & num = src.children[0];
 
-		if (!calc->is_int(num_final)) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate double factorial of non-"
-			                       L"integer");
-		} else if (num_final < -1) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate double factorial of"
-			                       L" integer below -1");
-		}
-
-		if (validate_only) return 1;
+		Num num_final = calc->execute_ast(num, validate_only);
 
-		Num factored = 1;
+		const wchar_t * error = UnaryKernels::dbl_factorial(calc, num_final,
+		                                                    validate_only);
 
-		for (Num i(1); i <= num_final; i++) {
-			if (i.numerator() % 2 == num_final.numerator() % 2) {
-				factored *= i;
-			}
+		if (error) {
+			throw CalcASTException(calc->get_token(num), error);
 		}
 
-		return factored;
+		return num_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Unary::super_factorial(Calculator<Num> * calc,
-	                                                CalcASTElem src,
+	                                                const CalcASTElem & src,
 	                                                bool validate_only) {
-		CalcASTElem num       = src.children[0];
-		Num         num_final = calc->execute_ast(num, validate_only);
-
-		if (!calc->is_int(num_final)) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate super factorial of non-"
-			                       L"integer");
-		} else if (num_final < 0) {
-			throw CalcASTException(calc->get_token(num),
-			                       L"Can't calculate super factorial of"
-			                       L" negative integer");
-		}
+		const CalcASTElem & num = src.children[0];
 
-		if (validate_only) return 1;
+		Num num_final = calc->execute_ast(num, validate_only);
 
-		Num factored  = 1;
-		Num factorial = 1;
+		const wchar_t * error = UnaryKernels::super_factorial(calc, num_final,
+		                                                      validate_only);
 
-		for (Num i(1); i <= num_final; i++) {
-			factorial *= i;
-			factored *= factorial;
+		if (error) {
+			throw CalcASTException(calc->get_token(num), error);
 		}
 
-		return factored;
+		return num_final;
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Unary::negation(Calculator<Num> * calc,
-	                                         CalcASTElem src,
+	                                         const CalcASTElem & src,
 	                                         bool validate_only) {
 		return -calc->execute_ast(src.children[0], validate_only);
 	}
 
 template <class Num>
 	Num CalcOperations<Num>::Unary::plus(Calculator<Num> * calc,
-	                                     CalcASTElem src, bool validate_only) {
+	                                     const CalcASTElem & src,
+	                                     bool validate_only) {
 		return calc->execute_ast(src.children[0], validate_only);
 	}
 
+template <class Num>
+	Num CalcOperations<Num>::Nary::sum(Calculator<Num> * calc,
+	                                   const CalcASTElem & src,
+	                                   bool validate_only) {
+		std::vector<Num>  values;
+		std::vector<bool> inverse;
+
+		for (unsigned long i = 0; i < src.children.size(); i++) {
+			values.push_back(calc->execute_ast(CalcFlatten::operand(src, i),
+			                                   validate_only));
+			inverse.push_back(CalcFlatten::inverse(src, i));
+		}
+
+		NaryKernels::sum(calc, values.data(), inverse, validate_only);
+
+		return values[0];
+	}
+
+template <class Num>
+	Num CalcOperations<Num>::Nary::product(Calculator<Num> * calc,
+	                                       const CalcASTElem & src,
+	                                       bool validate_only) {
+		std::vector<Num>  values;
+		std::vector<bool> inverse;
+
+		for (unsigned long i = 0; i < src.children.size(); i++) {
+			const CalcASTElem & operand = CalcFlatten::operand(src, i);
+
+			values.push_back(calc->execute_ast(operand, validate_only));
+			inverse.push_back(CalcFlatten::inverse(src, i));
+
+			/**
+			 * Dividing by 0 makes everything after it irrelevant
+			 */
+			if (inverse.back() && values.back() == 0 && !validate_only) {
+				throw CalcASTException(calc->get_token(operand),
+				                       L"Can't divide by 0");
+			}
+		}
+
+		NaryKernels::product(calc, values.data(), inverse, validate_only);
+
+		return values[0];
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::BinaryKernels::exponentiation(
+		Calculator<Num> * calc, Num & lhs, const Num & rhs,
+		bool validate_only) {
+		/**
+		 * Anything to the power of 0 is always 1.
+		 */
+		if (rhs == 0) {
+			lhs = 1;
+
+			return nullptr;
+		}
+
+		/**
+		 * Fractional exponents may not be rational, and our
+		 * arbitrary-precision types can only represent rational numbers
+		 */
+		if (!calc->is_int(rhs)) {
+			return L"Powers must be an integer";
+		}
+
+		/**
+		 * x^-n is 1/x^n
+		 */
+		bool reciprocal = rhs < 0;
+
+		if (reciprocal && lhs == 0) {
+			return L"Can't raise 0 to a negative power";
+		}
+
+		if (!validate_only) {
+			/**
+			 * The numerator and denominator have no common factors, so
+			 * neither do their powers. Raise them separately, as plain
+			 * integers, and the fraction they make is already in lowest
+			 * terms.
+			 */
+			math::Unsigned exp = rhs.numerator().abs();
+			math::Integer  num = IntegerMath::pow(lhs.numerator(), exp);
+			math::Integer  den = IntegerMath::pow(lhs.denominator(), exp);
+
+			lhs = reciprocal ? math::Rational(den, num)
+			                 : math::Rational(num, den);
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::BinaryKernels::multiplication(
+		Calculator<Num> * /* calc */, Num & lhs, const Num & rhs,
+		bool validate_only) {
+		/**
+		 * When validating, both sides have been checked already, so just
+		 * pass the right hand side along like the AST version always has
+		 */
+		if (validate_only) {
+			lhs = rhs;
+		} else {
+			lhs = Multiplication::multiply(lhs, rhs);
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::BinaryKernels::division(
+		Calculator<Num> * /* calc */, Num & lhs, const Num & rhs,
+		bool validate_only) {
+		if (rhs == 0) {
+			return L"Can't divide by 0";
+		}
+
+		if (!validate_only) {
+			lhs = Multiplication::divide(lhs, rhs);
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::BinaryKernels::addition(
+		Calculator<Num> * /* calc */, Num & lhs, const Num & rhs,
+		bool validate_only) {
+		if (validate_only) {
+			lhs = rhs;
+		} else {
+			lhs += rhs;
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::BinaryKernels::subtraction(
+		Calculator<Num> * /* calc */, Num & lhs, const Num & rhs,
+		bool validate_only) {
+		if (validate_only) {
+			lhs = rhs;
+		} else {
+			lhs -= rhs;
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::UnaryKernels::factorial(
+		Calculator<Num> * calc, Num & num, bool validate_only) {
+		if (!calc->is_int(num)) {
+			return L"Can't calculate factorial of non-integer";
+		} else if (num < 0) {
+			return L"Can't calculate factorial of negative integer";
+		}
+
+		std::uint64_t n;
+
+		if (!IntegerMath::to_word(num.numerator().abs(), n) ||
+		    n > max_factorial) {
+			return L"Can't calculate factorial of integer this large";
+		}
+
+		if (validate_only) {
+			num = 1;
+
+			return nullptr;
+		}
+
+		/**
+		 * All integers, so don't bother with fractions until the end
+		 */
+		try {
+			num = math::Rational(
+				math::Integer(calc->factorial_cache.factorial(n)), 1);
+		} catch (std::bad_alloc &) {
+			return L"Not enough memory to calculate factorial";
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::UnaryKernels::dbl_factorial(
+		Calculator<Num> * calc, Num & num, bool validate_only) {
+		if (!calc->is_int(num)) {
+			return L"Can't calculate double factorial of non-integer";
+		} else if (num < -1) {
+			return L"Can't calculate double factorial of integer below -1";
+		}
+
+		std::uint64_t n;
+
+		if (!IntegerMath::to_word(num.numerator().abs(), n) ||
+		    n > max_factorial) {
+			return L"Can't calculate double factorial of integer this large";
+		}
+
+		if (validate_only) {
+			num = 1;
+
+			return nullptr;
+		}
+
+		/**
+		 * (-1)!! is 1, just like 0!!
+		 */
+		if (num < 0) {
+			n = 0;
+		}
+
+		try {
+			num = math::Rational(
+				math::Integer(calc->factorial_cache.double_factorial(n)), 1);
+		} catch (std::bad_alloc &) {
+			return L"Not enough memory to calculate double factorial";
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::UnaryKernels::super_factorial(
+		Calculator<Num> * calc, Num & num, bool validate_only) {
+		if (!calc->is_int(num)) {
+			return L"Can't calculate super factorial of non-integer";
+		} else if (num < 0) {
+			return L"Can't calculate super factorial of negative integer";
+		}
+
+		std::uint64_t n;
+
+		if (!IntegerMath::to_word(num.numerator().abs(), n) ||
+		    n > max_super_factorial) {
+			return L"Can't calculate super factorial of integer this large";
+		}
+
+		if (validate_only) {
+			num = 1;
+
+			return nullptr;
+		}
+
+		try {
+			num = math::Rational(
+				math::Integer(calc->factorial_cache.super_factorial(n)), 1);
+		} catch (std::bad_alloc &) {
+			return L"Not enough memory to calculate super factorial";
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::UnaryKernels::negation(
+		Calculator<Num> * /* calc */, Num & num,
+		bool /* validate_only */) {
+		num = -num;
+
+		return nullptr;
+	}
+
+template <class Num>
+	const wchar_t * CalcOperations<Num>::UnaryKernels::plus(
+		Calculator<Num> * /* calc */, Num & /* num */,
+		bool /* validate_only */) {
+		return nullptr;
+	}
+
+template <class Num>
+	void CalcOperations<Num>::NaryKernels::sum(
+		Calculator<Num> * /* calc */, Num * values,
+		const std::vector<bool> & inverse, bool validate_only) {
+		if (validate_only) {
+			return;
+		}
+
+		CalcAccumulator<Num> result(values[0]);
+
+		for (unsigned long i = 1; i < inverse.size(); i++) {
+			result.add(values[i], inverse[i]);
+		}
+
+		values[0] = result.get();
+	}
+
+template <class Num>
+	void CalcOperations<Num>::NaryKernels::product(
+		Calculator<Num> * /* calc */, Num * values,
+		const std::vector<bool> & inverse, bool validate_only) {
+		if (validate_only) {
+			return;
+		}
+
+		CalcAccumulator<Num> result(values[0]);
+
+		for (unsigned long i = 1; i < inverse.size(); i++) {
+			result.multiply(values[i], inverse[i]);
+		}
+
+		values[0] = result.get();
+	}
+
 #endif //CALCULATOR_CALCOPERATIONS_CPP
@@ -1,6 +1,9 @@
 #ifndef CALCULATOR_CALCOPERATIONS_HPP
 #define CALCULATOR_CALCOPERATIONS_HPP
 
+#include <vector>
+#include <cstdint>
+
 #include "Calculator.hpp"
 #include "CalcASTElem.hpp"
 
@@ -14,7 +17,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num exponentiation(Calculator<Num> * calc, CalcASTElem src,
+			static Num exponentiation(Calculator<Num> * calc,
+			                          const CalcASTElem & src,
 			                          bool validate_only);
 
 			/**
@@ -24,7 +28,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num multiplication(Calculator<Num> * calc, CalcASTElem src,
+			static Num multiplication(Calculator<Num> * calc,
+			                          const CalcASTElem & src,
 			                          bool validate_only);
 
 			/**
@@ -34,7 +39,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num division(Calculator<Num> * calc, CalcASTElem src,
+			static Num division(Calculator<Num> * calc,
+			                    const CalcASTElem & src,
 			                    bool validate_only);
 
 			/**
@@ -44,7 +50,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num addition(Calculator<Num> * calc, CalcASTElem src,
+			static Num addition(Calculator<Num> * calc,
+			                    const CalcASTElem & src,
 			                    bool validate_only);
 
 			/**
@@ -54,7 +61,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num subtraction(Calculator<Num> * calc, CalcASTElem src,
+			static Num subtraction(Calculator<Num> * calc,
+			                       const CalcASTElem & src,
 			                       bool validate_only);
 
 			/**
@@ -64,7 +72,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num assignment(Calculator<Num> * calc, CalcASTElem src,
+			static Num assignment(Calculator<Num> * calc,
+			                      const CalcASTElem & src,
 			                      bool validate_only);
 		};
 
@@ -76,7 +85,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num factorial(Calculator<Num> * calc, CalcASTElem src,
+			static Num factorial(Calculator<Num> * calc,
+			                     const CalcASTElem & src,
 			                     bool validate_only);
 
 			/**
@@ -86,7 +96,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num dbl_factorial(Calculator<Num> * calc, CalcASTElem src,
+			static Num dbl_factorial(Calculator<Num> * calc,
+			                         const CalcASTElem & src,
 			                         bool validate_only);
 
 			/**
@@ -98,7 +109,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num super_factorial(Calculator<Num> * calc, CalcASTElem src,
+			static Num super_factorial(Calculator<Num> * calc,
+			                           const CalcASTElem & src,
 			                           bool validate_only);
 
 			/**
@@ -109,7 +121,8 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num negation(Calculator<Num> * calc, CalcASTElem src,
+			static Num negation(Calculator<Num> * calc,
+			                    const CalcASTElem & src,
 			                    bool validate_only);
 
 			/**
@@ -120,9 +133,130 @@ template <class Num>
 			 * @param src The AST element this is being executed on.
 			 * @return
 			 */
-			static Num plus(Calculator<Num> * calc, CalcASTElem src,
+			static Num plus(Calculator<Num> * calc,
+			                const CalcASTElem & src,
 			                bool validate_only);
 		};
+
+		/**
+		 * Chains made by [[CalcFlatten::flatten]]
+		 */
+		struct Nary {
+			/**
+			 * A chain of additions and subtractions ([[AST_SUM]]).
+			 *
+			 * @param calc The calculator this is being executed by.
+			 * @param src The AST element this is being executed on.
+			 * @return
+			 */
+			static Num sum(Calculator<Num> * calc, const CalcASTElem & src,
+			               bool validate_only);
+
+			/**
+			 * A chain of multiplications and divisions ([[AST_PRODUCT]]).
+			 *
+			 * @param calc The calculator this is being executed by.
+			 * @param src The AST element this is being executed on.
+			 * @return
+			 */
+			static Num product(Calculator<Num> * calc,
+			                   const CalcASTElem & src, bool validate_only);
+		};
+
+		/**
+		 * Kernels used by the bytecode evaluator. These do the actual math on
+		 * values that have already been evaluated, and the AST operations
+		 * above call into them so there's only one copy of every check.
+		 *
+		 * Each kernel writes its result into its first argument and returns
+		 * `nullptr`, or returns an error message without touching it. See
+		 * [[CalcBinaryKernel]].
+		 */
+		struct BinaryKernels {
+			static const wchar_t * exponentiation(Calculator<Num> * calc,
+			                                      Num & lhs, const Num & rhs,
+			                                      bool validate_only);
+
+			static const wchar_t * multiplication(Calculator<Num> * calc,
+			                                      Num & lhs, const Num & rhs,
+			                                      bool validate_only);
+
+			static const wchar_t * division(Calculator<Num> * calc,
+			                                Num & lhs, const Num & rhs,
+			                                bool validate_only);
+
+			static const wchar_t * addition(Calculator<Num> * calc,
+			                                Num & lhs, const Num & rhs,
+			                                bool validate_only);
+
+			static const wchar_t * subtraction(Calculator<Num> * calc,
+			                                   Num & lhs, const Num & rhs,
+			                                   bool validate_only);
+		};
+
+		/**
+		 * See [[CalcOperations::BinaryKernels]].
+		 */
+		struct UnaryKernels {
+			/**
+			 * The largest n that n! and n!! are worked out for. 10^7! is
+			 * about 27 MB already, and every factor of 10 past that is more
+			 * than 10 times as much.
+			 */
+			static const std::uint64_t max_factorial = 10000000;
+
+			/**
+			 * The largest n that n$ is worked out for, which is about 80 MB
+			 */
+			static const std::uint64_t max_super_factorial = 10000;
+
+			static const wchar_t * factorial(Calculator<Num> * calc,
+			                                 Num & num, bool validate_only);
+
+			static const wchar_t * dbl_factorial(Calculator<Num> * calc,
+			                                     Num & num, bool validate_only);
+
+			static const wchar_t * super_factorial(Calculator<Num> * calc,
+			                                       Num & num,
+			                                       bool validate_only);
+
+			static const wchar_t * negation(Calculator<Num> * calc,
+			                                Num & num, bool validate_only);
+
+			static const wchar_t * plus(Calculator<Num> * calc,
+			                            Num & num, bool validate_only);
+		};
+
+		/**
+		 * Kernels for chains made by [[CalcFlatten::flatten]]. These work on
+		 * every operand at once, using [[CalcAccumulator]], and write the
+		 * result into the first one.
+		 *
+		 * They can't fail. The only thing that could go wrong is dividing by
+		 * 0, and every divisor is checked as soon as it's evaluated, so that
+		 * the operands after it aren't (see [[OP_DIVISOR]]).
+		 */
+		struct NaryKernels {
+			/**
+			 * @param calc The calculator
+			 * @param values The operands, in order
+			 * @param inverse Whether each operand is subtracted
+			 * @param validate_only Whether to skip the math
+			 */
+			static void sum(Calculator<Num> * calc, Num * values,
+			                const std::vector<bool> & inverse,
+			                bool validate_only);
+
+			/**
+			 * @param calc The calculator
+			 * @param values The operands, in order
+			 * @param inverse Whether each operand is divided by
+			 * @param validate_only Whether to skip the math
+			 */
+			static void product(Calculator<Num> * calc, Num * values,
+			                    const std::vector<bool> & inverse,
+			                    bool validate_only);
+		};
 	};
 
 #endif //CALCULATOR_CALCOPERATIONS_HPP
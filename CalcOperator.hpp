@@ -19,10 +19,18 @@ template <class Num>
 		BinaryAssociativity associativity;
 		CalcOpFunc(Num)     func = 0;
 
+		/**
+		 * Used by the bytecode evaluator. Operators that can't be expressed
+		 * on plain values (like assignment) leave this as `nullptr` and are
+		 * compiled specially.
+		 */
+		CalcBinaryKernel<Num> kernel = nullptr;
+
 		CalcOperator(std::wstring op, unsigned order,
-		             BinaryAssociativity associativity, CalcOpFunc(Num) func)
+		             BinaryAssociativity associativity, CalcOpFunc(Num) func,
+		             CalcBinaryKernel<Num> kernel = nullptr)
 			: op(std::move(op)), order(order), associativity(associativity),
-			  func(func) {};
+			  func(func), kernel(kernel) {};
 	};
 
 enum UnaryAssociativity : bool {
@@ -36,9 +44,15 @@ template <class Num>
 		UnaryAssociativity associativity;
 		CalcOpFunc(Num)    func = 0;
 
+		/**
+		 * Used by the bytecode evaluator.
+		 */
+		CalcUnaryKernel<Num> kernel = nullptr;
+
 		CalcUOperator(std::wstring op, UnaryAssociativity associativity,
-		              CalcOpFunc(Num) func)
-			: op(std::move(op)), associativity(associativity), func(func) {};
+		              CalcOpFunc(Num) func, CalcUnaryKernel<Num> kernel)
+			: op(std::move(op)), associativity(associativity), func(func),
+			  kernel(kernel) {};
 	};
 
 #endif //CALCULATOR_CALCOPERATOR_HPP
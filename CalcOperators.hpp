@@ -2,8 +2,10 @@
 #define CALCULATOR_CALCOPERATORS_HPP
 
 #include <vector>
-#include <map>
+#include <string>
 
+#include "Token.hpp"
+#include "CalcASTException.hpp"
 #include "CalcOperator.hpp"
 #include "CalcOperations.cpp"
 
@@ -13,31 +15,121 @@ template <class Num>
 template <class Num>
 	using UnOps = typename CalcOperations<Num>::Unary;
 
+template <class Num>
+	using BinKernels = typename CalcOperations<Num>::BinaryKernels;
+
+template <class Num>
+	using UnKernels = typename CalcOperations<Num>::UnaryKernels;
+
+/**
+ * The operators. Operators are identified by their index in
+ * [[CalcOperators::binary_ops]] or [[CalcOperators::unary_ops]], which the
+ * tokenizer stores in [[Token::op]], so precedence, associativity and the
+ * implementation are all one array access away.
+ */
 template <class Num>
 	struct CalcOperators {
 		static std::vector<CalcOperator<Num>> binary_ops;
 		static std::vector<CalcUOperator<Num>> unary_ops;
 
-		static std::map<std::wstring, CalcOperator<Num>> binary_op_lookup;
-		static std::map<std::wstring, CalcUOperator<Num>> unary_op_lookup;
-
 		static std::wstring binary_op_str;
 		static std::wstring unary_op_str;
+
+		/**
+		 * Finds an operator by its string. This is done once per operator,
+		 * while tokenizing.
+		 *
+		 * @param op The operator, e.g. "+"
+		 * @return The index in [[CalcOperators::binary_ops]] or
+		 * [[CalcOperators::unary_ops]], or -1 if there is no such operator
+		 */
+		static int find_binary(const std::wstring & op);
+		static int find_unary(const std::wstring & op);
+
+		/**
+		 * Gets the index of the operator a TK_OPERATOR or TK_UOPERATOR token
+		 * stands for. That's [[Token::op]] for tokens from [[CalcTokenizer]],
+		 * but tokens made some other way are looked up by string.
+		 *
+		 * @param tk The token
+		 * @return The index in [[CalcOperators::binary_ops]] or
+		 * [[CalcOperators::unary_ops]], or -1 if there is no such operator
+		 */
+		static int find_binary(const Token & tk);
+		static int find_unary(const Token & tk);
+
+		/**
+		 * Same as [[CalcOperators::find_binary]] and
+		 * [[CalcOperators::find_unary]], but throws.
+		 *
+		 * @param tk The token
+		 * @return The index in [[CalcOperators::binary_ops]] or
+		 * [[CalcOperators::unary_ops]]
+		 * @throw CalcASTException if there is no such operator
+		 */
+		static unsigned binary_index(const Token & tk);
+		static unsigned unary_index(const Token & tk);
 	};
 
 template <class Op>
-	std::map<std::wstring, Op> create_lookup(const std::vector<Op> & ops) {
-		std::map<std::wstring, Op> lookup;
+	int find_op(const std::vector<Op> & ops, const std::wstring & op) {
+		for (unsigned i = 0; i < ops.size(); i++) {
+			if (ops[i].op == op) {
+				return static_cast<int>(i);
+			}
+		}
 
-		for (const Op & op : ops) {
-			/**
-			 * I would use `lookup[op.op] = op` but that causes templating
-			 * errors
-			 */
-			lookup.insert(std::make_pair(op.op, op));
+		return -1;
+	}
+
+template <class Op>
+	int find_op(const std::vector<Op> & ops, const Token & tk) {
+		if (tk.op >= 0 && static_cast<unsigned>(tk.op) < ops.size()) {
+			return tk.op;
 		}
 
-		return lookup;
+		return find_op(ops, tk.data);
+	}
+
+template <class Op>
+	unsigned op_index(const std::vector<Op> & ops, const Token & tk) {
+		int index = find_op(ops, tk);
+
+		if (index < 0) {
+			throw CalcASTException(tk, L"Invalid operation");
+		}
+
+		return static_cast<unsigned>(index);
+	}
+
+template <class Num>
+	int CalcOperators<Num>::find_binary(const std::wstring & op) {
+		return find_op(binary_ops, op);
+	}
+
+template <class Num>
+	int CalcOperators<Num>::find_unary(const std::wstring & op) {
+		return find_op(unary_ops, op);
+	}
+
+template <class Num>
+	int CalcOperators<Num>::find_binary(const Token & tk) {
+		return find_op(binary_ops, tk);
+	}
+
+template <class Num>
+	int CalcOperators<Num>::find_unary(const Token & tk) {
+		return find_op(unary_ops, tk);
+	}
+
+template <class Num>
+	unsigned CalcOperators<Num>::binary_index(const Token & tk) {
+		return op_index(binary_ops, tk);
+	}
+
+template <class Num>
+	unsigned CalcOperators<Num>::unary_index(const Token & tk) {
+		return op_index(unary_ops, tk);
 	}
 
 template <class Op>
@@ -53,35 +145,37 @@ template <class Op>
 
 template <class Num>
 	std::vector<CalcOperator<Num>> CalcOperators<Num>::binary_ops = {
-		CalcOperator<Num>(L"^", 3, ASSOCIATE_R, BinOps<Num>::exponentiation),
-		CalcOperator<Num>(L"*", 2, ASSOCIATE_L, BinOps<Num>::multiplication),
-		CalcOperator<Num>(L"/", 2, ASSOCIATE_L, BinOps<Num>::division),
-		CalcOperator<Num>(L"+", 1, ASSOCIATE_L, BinOps<Num>::addition),
-		CalcOperator<Num>(L"-", 1, ASSOCIATE_L, BinOps<Num>::subtraction),
+		CalcOperator<Num>(L"^", 3, ASSOCIATE_R, BinOps<Num>::exponentiation,
+		                  BinKernels<Num>::exponentiation),
+		CalcOperator<Num>(L"*", 2, ASSOCIATE_L, BinOps<Num>::multiplication,
+		                  BinKernels<Num>::multiplication),
+		CalcOperator<Num>(L"/", 2, ASSOCIATE_L, BinOps<Num>::division,
+		                  BinKernels<Num>::division),
+		CalcOperator<Num>(L"+", 1, ASSOCIATE_L, BinOps<Num>::addition,
+		                  BinKernels<Num>::addition),
+		CalcOperator<Num>(L"-", 1, ASSOCIATE_L, BinOps<Num>::subtraction,
+		                  BinKernels<Num>::subtraction),
 		CalcOperator<Num>(L"=", 0, ASSOCIATE_R, BinOps<Num>::assignment)
 	};
 
-template <class Num>
-	std::map<std::wstring, CalcOperator<Num>> CalcOperators<Num>::binary_op_lookup
-		= create_lookup(CalcOperators<Num>::binary_ops);
-
 template <class Num>
 	std::wstring CalcOperators<Num>::binary_op_str
 		= create_ops_str(CalcOperators<Num>::binary_ops);
 
 template <class Num>
 	std::vector<CalcUOperator<Num>> CalcOperators<Num>::unary_ops = {
-		CalcUOperator<Num>(L"!", UASSOCIATE_AFT, UnOps<Num>::factorial),
-		CalcUOperator<Num>(L"!!", UASSOCIATE_AFT, UnOps<Num>::dbl_factorial),
-		CalcUOperator<Num>(L"$", UASSOCIATE_AFT, UnOps<Num>::super_factorial),
-		CalcUOperator<Num>(L"-", UASSOCIATE_BEF, UnOps<Num>::negation),
-		CalcUOperator<Num>(L"+", UASSOCIATE_BEF, UnOps<Num>::plus)
+		CalcUOperator<Num>(L"!", UASSOCIATE_AFT, UnOps<Num>::factorial,
+		                   UnKernels<Num>::factorial),
+		CalcUOperator<Num>(L"!!", UASSOCIATE_AFT, UnOps<Num>::dbl_factorial,
+		                   UnKernels<Num>::dbl_factorial),
+		CalcUOperator<Num>(L"$", UASSOCIATE_AFT, UnOps<Num>::super_factorial,
+		                   UnKernels<Num>::super_factorial),
+		CalcUOperator<Num>(L"-", UASSOCIATE_BEF, UnOps<Num>::negation,
+		                   UnKernels<Num>::negation),
+		CalcUOperator<Num>(L"+", UASSOCIATE_BEF, UnOps<Num>::plus,
+		                   UnKernels<Num>::plus)
 	};
 
-template <class Num>
-	std::map<std::wstring, CalcUOperator<Num>> CalcOperators<Num>::unary_op_lookup
-		= create_lookup(CalcOperators<Num>::unary_ops);
-
 template <class Num>
 	std::wstring CalcOperators<Num>::unary_op_str
 		= create_ops_str(CalcOperators<Num>::unary_ops);
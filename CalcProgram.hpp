@@ -0,0 +1,144 @@
+#ifndef CALCULATOR_CALCPROGRAM_HPP
+#define CALCULATOR_CALCPROGRAM_HPP
+
+#include <vector>
+#include <string>
+
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcOpFunc.hpp"
+
+/**
+ * Opcodes understood by [[Calculator::execute_program]]. The evaluator is a
+ * simple stack machine, so every instruction either pushes a value, or pops
+ * its operands and pushes its result.
+ */
+enum CalcOpcode : unsigned char {
+	/**
+	 * Pushes `constants[arg]`.
+	 */
+	OP_CONST,
+
+	/**
+	 * Pushes the value of the variable in slot `arg` of
+	 * [[Calculator::variables]]. Fails if the variable doesn't exist.
+	 */
+	OP_LOAD,
+
+	/**
+	 * Assigns the top of the stack to the variable in slot `arg` of
+	 * [[Calculator::variables]]. The value stays on the stack, since
+	 * assignments return what they assigned.
+	 */
+	OP_STORE,
+
+	/**
+	 * Pops the right hand side, then applies binary operator `arg` to it and
+	 * the left hand side, which is replaced by the result.
+	 */
+	OP_BINARY,
+
+	/**
+	 * Applies unary operator `arg` to the top of the stack.
+	 */
+	OP_UNARY,
+
+	/**
+	 * Pushes the result of calling function `calls[arg]`.
+	 */
+	OP_CALL,
+
+	/**
+	 * Pops every operand of the sum `chains[arg]` and pushes the result (see
+	 * [[CalcOperations::NaryKernels::sum]]).
+	 */
+	OP_SUM,
+
+	/**
+	 * Pops every operand of the product `chains[arg]` and pushes the result
+	 * (see [[CalcOperations::NaryKernels::product]]).
+	 */
+	OP_PRODUCT,
+
+	/**
+	 * Fails if the top of the stack is 0. Comes right after every divisor in
+	 * a product, so dividing by 0 fails before the operands after it are
+	 * evaluated, like it would without [[OP_PRODUCT]].
+	 */
+	OP_DIVISOR
+};
+
+/**
+ * A single instruction. What `arg` means depends on the opcode.
+ */
+struct CalcInstr {
+	CalcOpcode op;
+	unsigned   arg;
+
+	CalcInstr(CalcOpcode op, unsigned arg) : op(op), arg(arg) {}
+};
+
+/**
+ * A compiled expression. See [[CalcBytecode::compile]].
+ *
+ * This is a flat list of instructions in evaluation order, plus the tables
+ * those instructions refer to. Compiling happens once, and evaluating doesn't
+ * need to look at the AST (except for function calls) or do any string work.
+ *
+ * Variables are referred to by their slot in [[Calculator::variables]], so a
+ * program can only be run by the calculator that compiled it (or a copy).
+ */
+template <class Num>
+	struct CalcProgram {
+		/**
+		 * The instructions, in the order they are executed
+		 */
+		std::vector<CalcInstr> code;
+
+		/**
+		 * Number literals, already parsed
+		 */
+		std::vector<Num> constants;
+
+		/**
+		 * Function calls. Functions are given their AST element, so they are
+		 * stored as-is.
+		 */
+		std::vector<CalcASTElem> calls;
+
+		/**
+		 * The function each of [[CalcProgram::calls]] runs, from
+		 * [[Calculator::bind]]
+		 */
+		std::vector<const CalcOpFunc(Num) *> functions;
+
+		/**
+		 * Sums and products. For every operand, in order, whether it's
+		 * subtracted or divided by. The first one never is.
+		 */
+		std::vector<std::vector<bool>> chains;
+
+		/**
+		 * The calculator that bound [[CalcProgram::functions]], and its
+		 * [[Calculator::functions_version]] at the time. Used by
+		 * [[Calculator::is_bound]].
+		 */
+		const void  * bound_by      = nullptr;
+		unsigned long bound_version = 0;
+
+		/**
+		 * Tokens used for error reporting, one for every instruction in
+		 * [[CalcProgram::code]]. These are the same tokens that
+		 * [[Calculator::get_token]] would have returned for the AST element
+		 * the error is about (for example, the divisor for division).
+		 */
+		std::vector<Token> spans;
+
+		/**
+		 * The deepest the stack will ever get, so the evaluator can allocate
+		 * it once.
+		 */
+		unsigned long max_stack = 0;
+	};
+
+#endif //CALCULATOR_CALCPROGRAM_HPP
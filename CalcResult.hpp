@@ -0,0 +1,91 @@
+#ifndef CALCULATOR_CALCRESULT_HPP
+#define CALCULATOR_CALCRESULT_HPP
+
+#include <string>
+#include <utility>
+
+#include "Token.hpp"
+#include "CalcASTException.hpp"
+
+/**
+ * What went wrong, and where. This is the same information a
+ * [[CalcASTException]] carries, but it's just a value, so nothing has to be
+ * thrown.
+ */
+struct CalcError {
+	/**
+	 * The token the error is about
+	 */
+	Token token;
+
+	/**
+	 * A user-friendly message that specifies what went wrong
+	 */
+	std::wstring msg;
+
+	CalcError(Token token, std::wstring msg)
+		: token(std::move(token)), msg(std::move(msg)) {}
+
+	/**
+	 * @return A [[CalcASTException]] with the same token and message
+	 */
+	CalcASTException exception() const {
+		return CalcASTException(token, msg);
+	}
+};
+
+/**
+ * Either a value, or a [[CalcError]] explaining why there isn't one.
+ *
+ * Functions that return this don't throw [[CalcASTException]]s. Most of them
+ * have a throwing counterpart that just calls [[CalcResult::get]].
+ *
+ * @tparam T The value type. Must be default constructible.
+ */
+template <class T>
+	class CalcResult {
+		T         value;
+		CalcError error;
+		bool      succeeded;
+
+		public:
+		/**
+		 * A successful result
+		 */
+		CalcResult(T value)
+			: value(std::move(value)), error(Token(), L""), succeeded(true) {}
+
+		/**
+		 * A failed result
+		 */
+		CalcResult(CalcError error)
+			: value(), error(std::move(error)), succeeded(false) {}
+
+		/**
+		 * @return Whether there is a value
+		 */
+		bool ok() const {
+			return succeeded;
+		}
+
+		/**
+		 * @return The value
+		 * @throw CalcASTException if there isn't one
+		 */
+		T & get() {
+			if (!succeeded) {
+				throw error.exception();
+			}
+
+			return value;
+		}
+
+		/**
+		 * @return The error. Only meaningful if not [[CalcResult::ok]].
+		 */
+		const CalcError & get_error() const {
+			return error;
+		}
+	};
+
+#endif //CALCULATOR_CALCRESULT_HPP
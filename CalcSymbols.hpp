@@ -0,0 +1,222 @@
+#ifndef CALCULATOR_CALCSYMBOLS_HPP
+#define CALCULATOR_CALCSYMBOLS_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+/**
+ * The calculator's variables.
+ *
+ * Every variable name is given a slot number the first time it's seen, which
+ * normally happens when an expression that uses it is compiled (see
+ * [[CalcSymbols::intern]]). Compiled programs only refer to variables by slot,
+ * so reading or assigning a variable is just an array access, without any
+ * string comparisons.
+ *
+ * A slot can exist without its variable being defined, so whether each slot
+ * is defined is tracked separately. Slots are never given back, even when a
+ * variable is deleted, since programs in [[Calculator::expression_cache]] may
+ * still refer to them.
+ *
+ * Lookups by name are still there for commands and the like, and behave like
+ * [[std::map]]'s.
+ *
+ * @tparam Num The number type
+ */
+template <class Num>
+	class CalcSymbols {
+		/**
+		 * Name -> slot. This is a [[std::map]] so that names come out sorted
+		 * when listing variables.
+		 */
+		std::map<std::wstring, unsigned> slots;
+
+		/**
+		 * Slot -> name
+		 */
+		std::vector<std::wstring> names;
+
+		/**
+		 * Slot -> value. Undefined slots hold a default constructed `Num`.
+		 */
+		std::vector<Num> values;
+
+		/**
+		 * Slot -> whether the variable is defined
+		 */
+		std::vector<bool> defined;
+
+		/**
+		 * How many slots are defined
+		 */
+		unsigned long count = 0;
+
+		public:
+		/**
+		 * Gets the slot for `name`, creating one if this is the first time
+		 * `name` has been seen. The variable isn't defined by this.
+		 *
+		 * @param name The variable name
+		 * @return The slot
+		 */
+		unsigned intern(const std::wstring & name) {
+			auto found = slots.find(name);
+
+			if (found != slots.end()) {
+				return found->second;
+			}
+
+			auto slot = static_cast<unsigned>(names.size());
+
+			slots.emplace(name, slot);
+			names.push_back(name);
+			values.emplace_back();
+			defined.push_back(false);
+
+			return slot;
+		}
+
+		/**
+		 * @return Whether `slot` holds a value
+		 */
+		bool is_defined(unsigned slot) const {
+			return defined[slot];
+		}
+
+		/**
+		 * @return The value in `slot`. Only meaningful if
+		 * [[CalcSymbols::is_defined]].
+		 */
+		const Num & get(unsigned slot) const {
+			return values[slot];
+		}
+
+		/**
+		 * Defines the variable in `slot` as `value`.
+		 *
+		 * @return The new value
+		 */
+		Num & set(unsigned slot, const Num & value) {
+			if (!defined[slot]) {
+				defined[slot] = true;
+				count++;
+			}
+
+			return values[slot] = value;
+		}
+
+		/**
+		 * Undefines the variable in `slot`. The slot itself stays.
+		 */
+		void undefine(unsigned slot) {
+			if (defined[slot]) {
+				defined[slot] = false;
+				values[slot]  = Num();
+				count--;
+			}
+		}
+
+		/**
+		 * @return The name of the variable in `slot`
+		 */
+		const std::wstring & name(unsigned slot) const {
+			return names[slot];
+		}
+
+		/**
+		 * Every slot there is, by name, sorted. Check
+		 * [[CalcSymbols::is_defined]] before using a slot's value.
+		 */
+		const std::map<std::wstring, unsigned> & get_slots() const {
+			return slots;
+		}
+
+		/**
+		 * Finds a defined variable by name.
+		 *
+		 * @return The value, or `nullptr` if it isn't defined
+		 */
+		const Num * find(const std::wstring & name) const {
+			auto found = slots.find(name);
+
+			if (found == slots.end() || !defined[found->second]) {
+				return nullptr;
+			}
+
+			return & values[found->second];
+		}
+
+		/**
+		 * Like [[std::map::at]].
+		 *
+		 * @throw std::out_of_range if the variable isn't defined
+		 */
+		const Num & at(const std::wstring & name) const {
+			const Num * found = find(name);
+
+			if (!found) {
+				throw std::out_of_range("Variable doesn't exist");
+			}
+
+			return * found;
+		}
+
+		/**
+		 * Like [[std::map::operator[]]], defines the variable if it isn't
+		 * already.
+		 */
+		Num & operator[](const std::wstring & name) {
+			unsigned slot = intern(name);
+
+			if (!defined[slot]) {
+				defined[slot] = true;
+				count++;
+			}
+
+			return values[slot];
+		}
+
+		/**
+		 * Undefines a variable by name.
+		 *
+		 * @return How many variables were removed (0 or 1)
+		 */
+		unsigned long erase(const std::wstring & name) {
+			auto found = slots.find(name);
+
+			if (found == slots.end() || !defined[found->second]) {
+				return 0;
+			}
+
+			undefine(found->second);
+
+			return 1;
+		}
+
+		/**
+		 * Undefines every variable. Slots are kept.
+		 */
+		void clear() {
+			for (unsigned slot = 0; slot < names.size(); slot++) {
+				undefine(slot);
+			}
+		}
+
+		/**
+		 * @return How many variables are defined
+		 */
+		unsigned long size() const {
+			return count;
+		}
+
+		/**
+		 * @return Whether no variables are defined
+		 */
+		bool empty() const {
+			return count == 0;
+		}
+	};
+
+#endif //CALCULATOR_CALCSYMBOLS_HPP
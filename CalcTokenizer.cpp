@@ -176,6 +176,7 @@ template <class Num>
 				}
 
 				push_token(unary ? TK_UOPERATOR : TK_OPERATOR);
+				identify_op();
 
 				/**
 				 * This only happens if there are 2 operators in a row
@@ -207,8 +208,15 @@ template <class Num>
 					move();
 				}
 
-				bool after = uassociativity(get_token_data())
-				             == UASSOCIATE_AFT;
+				int op = CalcOperators<Num>::find_unary(get_token_data());
+
+				if (op < 0) {
+					push_token(TK_UNKNOWN);
+
+					throw CalcASTException(tokens.back(), L"Unknown operator");
+				}
+
+				bool after = unary_ops[op].associativity == UASSOCIATE_AFT;
 
 				/**
 				 * Throw an error if this is a trailing token after an operator,
@@ -225,6 +233,7 @@ template <class Num>
 				                       : !after_operator();
 
 				push_token(TK_UOPERATOR);
+				tokens.back().op = op;
 
 				if (throw_err) {
 					throw CalcASTException(tokens.back(),
@@ -278,6 +287,7 @@ template <class Num>
 						move();
 						push_token(TK_OPERATOR);
 						tokens.back().data = L"*";
+						identify_op();
 						move(-1);
 					} else if (function_paren) {
 						tokens.back().type = TK_FUNCTION;
@@ -350,7 +360,7 @@ template <class Num>
 		return (tk.type & (TK_VARIABLE | TK_NUMBER | TK_CPAREN)) != 0 ||
 		       (
 			       tk.type == TK_UOPERATOR &&
-			       uassociativity(tk.data) == UASSOCIATE_AFT
+			       uassociativity(tk) == UASSOCIATE_AFT
 		       );
 	}
 
@@ -384,7 +394,7 @@ template <class Num>
 		Token & tk = tokens.back();
 
 		return tk.type == TK_UOPERATOR &&
-		       uassociativity(tk.data) == UASSOCIATE_BEF;
+		       uassociativity(tk) == UASSOCIATE_BEF;
 	}
 
 template <class Num>
@@ -395,12 +405,24 @@ template <class Num>
 		push_token(type);
 		move(-1);
 		tokens.back().data = op;
+		identify_op();
+	}
+
+template <class Num>
+	void CalcTokenizer<Num>::identify_op() {
+		Token & tk = tokens.back();
+
+		if (tk.type == TK_OPERATOR) {
+			tk.op = CalcOperators<Num>::find_binary(tk.data);
+		} else if (tk.type == TK_UOPERATOR) {
+			tk.op = CalcOperators<Num>::find_unary(tk.data);
+		}
 	}
 
 template <class Num>
 	UnaryAssociativity
-	CalcTokenizer<Num>::uassociativity(std::wstring op) {
-		return CalcOperators<Num>::unary_op_lookup.at(op).associativity;
+	CalcTokenizer<Num>::uassociativity(const Token & tk) {
+		return unary_ops[CalcOperators<Num>::unary_index(tk)].associativity;
 	}
 
 template <class Num>
@@ -87,10 +87,15 @@ template <class Num>
 		bool after_uop();
 
 		/**
-		 * @param op
-		 * @return the associacivity of unary operator `op`
+		 * @param tk
+		 * @return the associacivity of unary operator token `tk`
 		 */
-		UnaryAssociativity uassociativity(std::wstring op);
+		UnaryAssociativity uassociativity(const Token & tk);
+
+		/**
+		 * Sets [[Token::op]] of the last token, if it's an operator.
+		 */
+		void identify_op();
 
 		/**
 		 * Pushes a token that isn't actually in the input stream, but is
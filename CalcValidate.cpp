@@ -0,0 +1,374 @@
+#ifndef CALCULATOR_CALCVALIDATE_CPP
+#define CALCULATOR_CALCVALIDATE_CPP
+
+#include <set>
+#include <string>
+#include <vector>
+#include <exception>
+
+#include "CalcValidate.hpp"
+#include "Token.hpp"
+#include "CalcASTElem.hpp"
+#include "CalcASTEnum.hpp"
+#include "CalcASTException.hpp"
+#include "CalcResult.hpp"
+#include "CalcOperators.hpp"
+#include "CalcFlatten.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+
+/**
+ * Namespace for validation, which checks whether an AST would run without
+ * actually running it
+ */
+namespace CalcValidate {
+	namespace {
+		template <class Num>
+			bool cheap_value(const CalcASTElem & ast, Calculator<Num> & calc,
+			                 const std::vector<Num> * constants, Num & value) {
+				if (ast.token.type == TK_NUMBER) {
+					if (constants && ast.constant >= 0 &&
+					    static_cast<unsigned long>(ast.constant) <
+					    constants->size()) {
+						value = (* constants)[ast.constant];
+
+						return true;
+					} else if (ast.type == AST_CONSTANT) {
+						/**
+						 * The token is the whole subtree that was folded, not
+						 * a number
+						 */
+						return false;
+					}
+
+					try {
+						value = Num(LD::w2str(ast.token.data));
+					} catch (std::exception &) {
+						return false;
+					}
+
+					return true;
+				} else if (ast.token.type != TK_UOPERATOR) {
+					return false;
+				}
+
+				/**
+				 * Signs don't cost anything, everything else (factorials) can
+				 * be arbitrarily expensive
+				 */
+				int op = CalcOperators<Num>::find_unary(ast.token);
+
+				if (op < 0) {
+					return false;
+				}
+
+				auto kernel = CalcOperators<Num>::unary_ops[op].kernel;
+
+				if (kernel != CalcOperations<Num>::UnaryKernels::negation &&
+				    kernel != CalcOperations<Num>::UnaryKernels::plus) {
+					return false;
+				}
+
+				return cheap_value(ast.children[0], calc, constants, value) &&
+				       !kernel(& calc, value, false);
+			}
+
+		template <class Num>
+			CalcResult<bool> check_elem(const CalcASTElem & ast,
+			                            Calculator<Num> & calc,
+			                            const std::vector<Num> * constants,
+			                            std::set<std::wstring> & assigned) {
+				if (ast.type == AST_SUM || ast.type == AST_PRODUCT) {
+					/**
+					 * Same as a tree of binary operations, checked in the
+					 * order they would've run in
+					 */
+					for (unsigned long i = 0; i < ast.children.size(); i++) {
+						const CalcASTElem & operand =
+							CalcFlatten::operand(ast, i);
+
+						CalcResult<bool> result = check_elem(operand, calc,
+						                                     constants,
+						                                     assigned);
+
+						if (!result.ok()) {
+							return result;
+						}
+
+						Num value;
+
+						if (i == 0 ||
+						    !cheap_value(operand, calc, constants, value)) {
+							continue;
+						}
+
+						int  op     = CalcOperators<Num>::find_binary(
+							ast.children[i].token);
+						Num  lhs    = 1;
+						auto kernel = CalcOperators<Num>::binary_ops[op].kernel;
+
+						if (const wchar_t * error = kernel(& calc, lhs, value,
+						                                   true)) {
+							return CalcError(calc.get_token(operand), error);
+						}
+					}
+
+					return true;
+				} else if (ast.token.type == TK_NUMBER) {
+					if (ast.type == AST_CONSTANT ||
+					    (constants && ast.constant >= 0 &&
+					     static_cast<unsigned long>(ast.constant) <
+					     constants->size())) {
+						return true;
+					}
+
+					/**
+					 * Parsing a number is the only way to find out whether
+					 * it's a valid one
+					 */
+					try {
+						Num(LD::w2str(ast.token.data));
+					} catch (std::exception & e) {
+						return CalcError(ast.token,
+						                 L"Invalid number (" +
+						                 LD::c2wstr(e.what()) + L")");
+					}
+
+					return true;
+				} else if (ast.token.type == TK_VARIABLE) {
+					if (!calc.variables.find(ast.token.data) &&
+					    !assigned.count(ast.token.data)) {
+						return CalcError(ast.token, L"Variable doesn't exist");
+					}
+
+					return true;
+				} else if (ast.token.type == TK_OPERATOR) {
+					int op = CalcOperators<Num>::find_binary(ast.token);
+
+					if (op < 0 || ast.children.size() != 2) {
+						return CalcError(ast.token, L"Invalid operation");
+					}
+
+					const CalcASTElem & lhs = ast.children[0];
+					const CalcASTElem & rhs = ast.children[1];
+
+					if (ast.token.data == L"=") {
+						/**
+						 * 3 = 3.141592653589793
+						 *
+						 * I don't think so
+						 */
+						if (lhs.token.type != TK_VARIABLE) {
+							return CalcError(calc.get_token(lhs),
+							                 L"Can't assign to non-variable");
+						} else if (lhs.token.data == L"_") {
+							return CalcError(calc.get_token(lhs),
+							                 L"Assignment will be overwritten");
+						}
+
+						/**
+						 * The right hand side runs first, so `x = x + 1` still
+						 * needs `x` to exist
+						 */
+						CalcResult<bool> result = check_elem(rhs, calc,
+						                                     constants,
+						                                     assigned);
+
+						if (result.ok()) {
+							assigned.insert(lhs.token.data);
+						}
+
+						return result;
+					}
+
+					auto kernel = CalcOperators<Num>::binary_ops[op].kernel;
+
+					if (!kernel) {
+						return CalcError(ast.token, L"Invalid operation");
+					}
+
+					for (const CalcASTElem & child : ast.children) {
+						CalcResult<bool> result = check_elem(child, calc,
+						                                     constants,
+						                                     assigned);
+
+						if (!result.ok()) {
+							return result;
+						}
+					}
+
+					/**
+					 * Kernels mostly care about the right hand side. The left
+					 * hand side is only passed along in case it matters (like
+					 * the 0 in `0 ^ -1`), and it's 1 if it isn't cheap, which
+					 * no kernel complains about.
+					 */
+					Num rhs_value;
+
+					if (cheap_value(rhs, calc, constants, rhs_value)) {
+						Num lhs_value = 1;
+
+						cheap_value(lhs, calc, constants, lhs_value);
+
+						if (const wchar_t * error = kernel(& calc, lhs_value,
+						                                   rhs_value, true)) {
+							return CalcError(calc.get_token(rhs), error);
+						}
+					}
+
+					return true;
+				} else if (ast.token.type == TK_UOPERATOR) {
+					int op = CalcOperators<Num>::find_unary(ast.token);
+
+					if (op < 0 || ast.children.size() != 1) {
+						return CalcError(ast.token, L"Invalid operation");
+					}
+
+					const CalcASTElem & num = ast.children[0];
+
+					CalcResult<bool> result = check_elem(num, calc, constants,
+					                                     assigned);
+
+					if (!result.ok()) {
+						return result;
+					}
+
+					Num value;
+
+					if (cheap_value(num, calc, constants, value)) {
+						if (const wchar_t * error =
+							CalcOperators<Num>::unary_ops[op]
+								.kernel(& calc, value, true)) {
+							return CalcError(calc.get_token(num), error);
+						}
+					}
+
+					return true;
+				} else if (ast.token.type == TK_FUNCTION) {
+					const CalcOpFunc(Num) * func = calc.find_function(
+						ast.token.data,
+						static_cast<unsigned>(ast.children.size()));
+
+					if (!func) {
+						return CalcError(calc.get_token(ast),
+						                 L"Invalid function call");
+					}
+
+					/**
+					 * Missing variables can be found without calling the
+					 * function, and without it throwing
+					 */
+					CalcResult<bool> arguments = check_arguments(ast, calc,
+					                                             & assigned);
+
+					if (!arguments.ok()) {
+						return arguments;
+					}
+
+					/**
+					 * Only the function knows what its arguments mean (the
+					 * first argument to stdvar() isn't a variable, for
+					 * example), so let it check them. It comes back here
+					 * through [[Calculator::execute_ast]].
+					 */
+					try {
+						if (constants) {
+							calc.call_function(* func, ast, * constants, true);
+						} else {
+							(* func)(& calc, ast, true);
+						}
+					} catch (CalcASTException & e) {
+						return CalcError(e.get_token(), e.get_msg());
+					} catch (std::exception & e) {
+						return CalcError(calc.get_token(ast),
+						                 LD::c2wstr(e.what()));
+					}
+
+					return true;
+				}
+
+				return CalcError(ast.token, L"Unknown AST element");
+			}
+
+		template <class Num>
+			CalcResult<bool> check_reads(const CalcASTElem & ast,
+			                             Calculator<Num> & calc,
+			                             std::set<std::wstring> & assigned) {
+				if (ast.type == AST_CONSTANT) {
+					return true;
+				} else if (ast.token.type == TK_VARIABLE) {
+					if (!calc.variables.find(ast.token.data) &&
+					    !assigned.count(ast.token.data)) {
+						return CalcError(ast.token, L"Variable doesn't exist");
+					}
+
+					return true;
+				} else if (ast.token.type == TK_FUNCTION &&
+				           calc.raw_funcs.count(ast.token.data)) {
+					return true;
+				} else if (ast.token.type == TK_OPERATOR &&
+				           ast.token.data == L"=" &&
+				           ast.children.size() == 2) {
+					/**
+					 * The right hand side runs first, and the variable exists
+					 * from then on
+					 */
+					CalcResult<bool> result = check_reads(ast.children[1],
+					                                      calc, assigned);
+
+					if (result.ok()) {
+						assigned.insert(ast.children[0].token.data);
+					}
+
+					return result;
+				}
+
+				for (const CalcASTElem & child : ast.children) {
+					CalcResult<bool> result = check_reads(child, calc,
+					                                      assigned);
+
+					if (!result.ok()) {
+						return result;
+					}
+				}
+
+				return true;
+			}
+	}
+
+	template <class Num>
+		CalcResult<bool> check_arguments(
+			const CalcASTElem & call, Calculator<Num> & calc,
+			const std::set<std::wstring> * assigned) {
+			if (calc.raw_funcs.count(call.token.data)) {
+				return true;
+			}
+
+			std::set<std::wstring> so_far;
+
+			if (assigned) {
+				so_far = * assigned;
+			}
+
+			for (const CalcASTElem & child : call.children) {
+				CalcResult<bool> result = check_reads(child, calc, so_far);
+
+				if (!result.ok()) {
+					return result;
+				}
+			}
+
+			return true;
+		}
+
+	template <class Num>
+		CalcResult<bool> validate(const CalcASTElem & ast,
+		                          Calculator<Num> & calc,
+		                          const std::vector<Num> * constants) {
+			std::set<std::wstring> assigned;
+
+			return check_elem(ast, calc, constants, assigned);
+		}
+}
+
+#endif //CALCULATOR_CALCVALIDATE_CPP
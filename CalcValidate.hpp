@@ -0,0 +1,115 @@
+#ifndef CALCULATOR_CALCVALIDATE_HPP
+#define CALCULATOR_CALCVALIDATE_HPP
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "CalcASTElem.hpp"
+#include "CalcResult.hpp"
+
+template <class Num>
+	class Calculator;
+
+/**
+ * Namespace for validation, which checks whether an AST would run without
+ * actually running it
+ */
+namespace CalcValidate {
+	namespace {
+		/**
+		 * Gets the value of `ast` if that's cheap, which is only the case for
+		 * numbers, folded constants, and those with a sign in front.
+		 *
+		 * @param ast The AST element
+		 * @param calc The calculator
+		 * @param constants The constant pool, or `nullptr`
+		 * @param value Where to put the value
+		 * @return Whether there was a cheap value to put in `value`
+		 */
+		template <class Num>
+			bool cheap_value(const CalcASTElem & ast, Calculator<Num> & calc,
+			                 const std::vector<Num> * constants, Num & value);
+
+		/**
+		 * Checks `ast` and all of its children, in the order a program
+		 * would run them.
+		 *
+		 * @param ast The AST element to check
+		 * @param calc The calculator
+		 * @param constants The constant pool, or `nullptr`
+		 * @param assigned Variables assigned earlier in the expression. They
+		 * don't exist yet, but they will by the time they're used.
+		 * @return What's wrong, if anything
+		 */
+		template <class Num>
+			CalcResult<bool> check_elem(const CalcASTElem & ast,
+			                            Calculator<Num> & calc,
+			                            const std::vector<Num> * constants,
+			                            std::set<std::wstring> & assigned);
+
+		/**
+		 * Checks that every variable `ast` reads exists, in the order a
+		 * program would read them.
+		 *
+		 * @param ast The AST element to check
+		 * @param calc The calculator
+		 * @param assigned Variables assigned so far. Assignments in `ast`
+		 * are added to it.
+		 * @return What's wrong, if anything
+		 */
+		template <class Num>
+			CalcResult<bool> check_reads(const CalcASTElem & ast,
+			                             Calculator<Num> & calc,
+			                             std::set<std::wstring> & assigned);
+	}
+
+	/**
+	 * Checks that the arguments of the function call `call` don't read any
+	 * variables that don't exist, without calling the function.
+	 *
+	 * Functions report errors by throwing, so a missing variable would
+	 * otherwise be thrown from inside the function and caught on the way
+	 * out, on every call. Arguments of [[Calculator::raw_funcs]] aren't
+	 * checked, since some of them aren't variables at all.
+	 *
+	 * @param call The function call
+	 * @param calc The calculator it would be run by
+	 * @param assigned Variables assigned earlier in the expression, or
+	 * `nullptr` if none
+	 * @return `true`, or the first variable that doesn't exist
+	 */
+	template <class Num>
+		CalcResult<bool> check_arguments(
+			const CalcASTElem & call, Calculator<Num> & calc,
+			const std::set<std::wstring> * assigned = nullptr);
+
+	/**
+	 * Checks that running `ast` wouldn't fail, without doing any of the math.
+	 *
+	 * This checks the structure of the AST, that every operator and function
+	 * exists (functions with the right number of arguments), that
+	 * assignments assign to variables, and that variables exist, either
+	 * already or because something earlier in the expression assigns them.
+	 *
+	 * The only values looked at are cheap ones, like the 0 in `x / 0` or the
+	 * -1 in `(-1)!`. Something like `x ^ (100!)` is fine as far as this is
+	 * concerned, and `100!` isn't calculated. That means some inputs that
+	 * pass will still fail when they're run, `1 / (3 - 3)` for example.
+	 *
+	 * Functions check their own arguments (see
+	 * [[Calculator::execute_ast]] with `validate_only`), so they get called.
+	 *
+	 * @param ast The AST to check
+	 * @param calc The calculator the AST would be run by
+	 * @param constants The constant pool the AST's numbers point into, or
+	 * `nullptr` to parse them
+	 * @return `true`, or what's wrong
+	 */
+	template <class Num>
+		CalcResult<bool> validate(const CalcASTElem & ast,
+		                          Calculator<Num> & calc,
+		                          const std::vector<Num> * constants = nullptr);
+}
+
+#endif //CALCULATOR_CALCVALIDATE_HPP
@@ -8,10 +8,15 @@
 #include <sstream>
 #include <iterator>
 #include <iostream>
+#include <algorithm>
 
 #include "Calculator.hpp"
 #include "CalcTokenizer.cpp"
 #include "CalcAST.cpp"
+#include "CalcBytecode.cpp"
+#include "CalcFold.cpp"
+#include "CalcFlatten.cpp"
+#include "CalcValidate.cpp"
 #include "CalcOperators.hpp"
 
 #include "boilerplate/ld_boilerplate.hpp"
@@ -48,9 +53,15 @@ template <class Num>
 	}
 
 template <class Num>
-	CalcASTElem Calculator<Num>::get_ast(std::vector<Token> tokens) {
+	CalcASTElem Calculator<Num>::get_ast(std::vector<Token> tokens,
+	                                     bool * implicit_last,
+	                                     std::vector<Num> * constants) {
 		Token & first = tokens.front();
 
+		if (implicit_last) {
+			* implicit_last = false;
+		}
+
 		/**
 		 * if the first token is an operator, the user may want to perform an
 		 * operation on the last result
@@ -72,18 +83,21 @@ template <class Num>
 				    tokens.at(1)
 				          .type & (TK_NUMBER | TK_VARIABLE | TK_OPAREN)
 			    )) {
-				try {
-					variables.at(L"_");
-					tokens.insert(tokens.begin(), Token(TK_VARIABLE, L"_", 0));
-				} catch (std::out_of_range &) {
+				if (!variables.is_defined(result_slot)) {
 					throw CalcASTException(tokens.front(),
 					                       L"No previous result for implicit"
 					                       L" operation");
 				}
+
+				tokens.insert(tokens.begin(), Token(TK_VARIABLE, L"_", 0));
+
+				if (implicit_last) {
+					* implicit_last = true;
+				}
 			}
 		}
 
-		CalcASTElem ast = CalcAST::generate_ast<Num>(tokens, * this);
+		CalcASTElem ast = CalcAST::generate_ast<Num>(tokens, * this, constants);
 
 		if (ast_debug_force) {
 			std::cout << "FORCED AST:\n" + LD::w2str(stringify_ast(ast)) + "\n"
@@ -93,6 +107,39 @@ template <class Num>
 		return ast;
 	}
 
+template <class Num>
+	CalcExpression<Num> Calculator<Num>::parse(const std::wstring & input) {
+		CalcExpression<Num> expression;
+		std::vector<Num>    constants;
+
+		expression.tokens  = tokenize(input);
+		expression.ast     = get_ast(expression.tokens,
+		                             & expression.implicit_last, & constants);
+		expression.program = compile(expression.ast, std::move(constants));
+
+		return expression;
+	}
+
+template <class Num>
+	void Calculator<Num>::fold(CalcExpression<Num> & expression) {
+		if (expression.folded) {
+			return;
+		}
+
+		std::vector<Num> constants = expression.program.constants;
+
+		expression.folded_ast = CalcFlatten::flatten(
+			CalcFold::fold(expression.ast, * this, constants));
+		expression.program    = compile(expression.folded_ast,
+		                                std::move(constants));
+		expression.folded     = true;
+	}
+
+template <class Num>
+	void Calculator<Num>::invalidate_cache() {
+		expression_cache.clear();
+	}
+
 template <class Num>
 	Calculator<Num>::Calculator() {
 		commands[L"help"] =
@@ -312,8 +359,14 @@ template <class Num>
 template <class Num>
 	Num Calculator<Num>::execute_ast(const CalcASTElem & ast,
 	                                 bool validate_only, bool set_) {
+		if (validate_only) {
+			validate(ast, constant_pool);
+
+			return Num();
+		}
+
 		if (set_) {
-			return variables[L"_"] = execute_ast(ast, validate_only);
+			return variables.set(result_slot, execute_ast(ast));
 		}
 
 		if (ast.token.type == TK_NUMBER) {
@@ -323,7 +376,16 @@ template <class Num>
 			 * Jokes aside, if this fails, we can't try anything else. Throw
 			 * an exception and leave it up to the caller to resolve
 			 * any catastrophic system failure.
+			 *
+			 * Numbers inside a program being run were already parsed, so
+			 * use those when possible.
 			 */
+			if (constant_pool && ast.constant >= 0 &&
+			    static_cast<unsigned long>(ast.constant) <
+			    constant_pool->size()) {
+				return (* constant_pool)[ast.constant];
+			}
+
 			try {
 				return Num(LD::w2str(ast.token.data));
 			} catch (std::exception & e) {
@@ -334,61 +396,342 @@ template <class Num>
 		} else if (ast.token.type == TK_VARIABLE) {
 			/**
 			 * Just like numbers, except this time we retrieve it from
-			 * a map.
+			 * [[Calculator::variables]].
 			 */
-			try {
-				return variables.at(ast.token.data);
-			} catch (std::out_of_range &) {
+			const Num * value = variables.find(ast.token.data);
+
+			if (!value) {
 				throw CalcASTException(ast.token, L"Variable doesn't exist");
 			}
+
+			return * value;
+		} else if (ast.type == AST_SUM) {
+			return CalcOperations<Num>::Nary::sum(this, ast, validate_only);
+		} else if (ast.type == AST_PRODUCT) {
+			return CalcOperations<Num>::Nary::product(this, ast,
+			                                          validate_only);
 		} else if (ast.token.type & (TK_UOPERATOR | TK_OPERATOR)) {
-			try {
-				/**
-				 * if it's a binary operator, great, if it's not, it must be
-				 * unary (TK_UOPERATOR)
-				 */
-				return ast.token.type == TK_OPERATOR
-				       ? CalcOperators<Num>::binary_op_lookup
-					       .at(ast.token.data)
-					       .func(this, ast, validate_only)
-				       : CalcOperators<Num>::unary_op_lookup
-					       .at(ast.token.data)
-					       .func(this, ast, validate_only);
-			} catch (std::out_of_range &) {
-				throw CalcASTException(ast.token, L"Invalid operation");
-			}
+			/**
+			 * if it's a binary operator, great, if it's not, it must be
+			 * unary (TK_UOPERATOR)
+			 */
+			return ast.token.type == TK_OPERATOR
+			       ? CalcOperators<Num>::binary_ops[
+				       CalcOperators<Num>::binary_index(ast.token)]
+				       .func(this, ast, validate_only)
+			       : CalcOperators<Num>::unary_ops[
+				       CalcOperators<Num>::unary_index(ast.token)]
+				       .func(this, ast, validate_only);
 		} else if (ast.token.type == TK_FUNCTION) {
-			bool regular_function  = true;
-			bool variadic_function = true;
+			const CalcOpFunc(Num) * func = find_function(
+				ast.token.data, static_cast<unsigned>(ast.children.size()));
 
-			CalcOpFunc(Num) * func = nullptr;
+			if (!func) {
+				throw CalcASTException(get_token(ast),
+				                       L"Invalid function call");
+			}
 
-			try {
-				func = & functions
-					.at(ast.token.data)
-					.at(static_cast<unsigned>(ast.children.size()));
-			} catch (std::out_of_range &) {
-				regular_function = false;
+			return (* func)(this, ast, validate_only);
+		} else {
+			throw CalcASTException(ast.token, L"Unknown AST element");
+		}
+	}
+
+template <class Num>
+	Num Calculator<Num>::execute_ast(const CalcASTElem & ast,
+	                                 const std::vector<Num> & constants,
+	                                 bool validate_only) {
+		/**
+		 * Calls can nest (functions can run other programs), so put back
+		 * whatever was there before
+		 */
+		const std::vector<Num> * outer_pool = constant_pool;
+		constant_pool = & constants;
+
+		try {
+			Num result = execute_ast(ast, validate_only);
+
+			constant_pool = outer_pool;
+
+			return result;
+		} catch (...) {
+			constant_pool = outer_pool;
+
+			throw;
+		}
+	}
+
+template <class Num>
+	Num Calculator<Num>::call_function(const CalcOpFunc(Num) & func,
+	                                   const CalcASTElem & ast,
+	                                   const std::vector<Num> & constants,
+	                                   bool validate_only) {
+		const std::vector<Num> * outer_pool = constant_pool;
+		constant_pool = & constants;
+
+		try {
+			Num result = func(this, ast, validate_only);
+
+			constant_pool = outer_pool;
+
+			return result;
+		} catch (...) {
+			constant_pool = outer_pool;
+
+			throw;
+		}
+	}
+
+template <class Num>
+	const CalcOpFunc(Num) * Calculator<Num>::find_function(
+		const std::wstring & name, unsigned arity) {
+		auto found = functions.find(name);
+
+		if (found != functions.end()) {
+			auto found_arity = found->second.find(arity);
+
+			if (found_arity != found->second.end()) {
+				return & found_arity->second;
+			}
+		}
+
+		auto found_variadic = variadic_funcs.find(name);
+
+		if (found_variadic != variadic_funcs.end()) {
+			return & found_variadic->second;
+		}
+
+		return nullptr;
+	}
+
+template <class Num>
+	CalcResult<bool> Calculator<Num>::try_bind(CalcProgram<Num> & program) {
+		program.functions.clear();
+		program.functions.reserve(program.calls.size());
+
+		for (unsigned long i = 0; i < program.calls.size(); i++) {
+			const CalcASTElem & call = program.calls[i];
+			const CalcOpFunc(Num) * func = find_function(
+				call.token.data, static_cast<unsigned>(call.children.size()));
+
+			if (!func) {
+				return CalcError(get_token(call), L"Invalid function call");
 			}
 
-			if (!regular_function) {
-				try {
-					func = & variadic_funcs
-						.at(ast.token.data);
-				} catch (std::out_of_range &) {
-					variadic_function = false;
+			program.functions.push_back(func);
+		}
+
+		program.bound_by      = this;
+		program.bound_version = functions_version;
+
+		return true;
+	}
+
+template <class Num>
+	void Calculator<Num>::bind(CalcProgram<Num> & program) {
+		try_bind(program).get();
+	}
+
+template <class Num>
+	bool Calculator<Num>::is_bound(const CalcProgram<Num> & program) {
+		return program.bound_by == this &&
+		       program.bound_version == functions_version;
+	}
+
+template <class Num>
+	void Calculator<Num>::functions_changed() {
+		functions_version++;
+
+		/**
+		 * Folded expressions may have called the old functions
+		 */
+		invalidate_cache();
+	}
+
+template <class Num>
+	CalcProgram<Num> Calculator<Num>::compile(const CalcASTElem & ast,
+	                                          std::vector<Num> constants) {
+		return CalcBytecode::compile<Num>(ast, * this, std::move(constants));
+	}
+
+template <class Num>
+	CalcResult<CalcProgram<Num>> Calculator<Num>::try_compile(
+		const CalcASTElem & ast, std::vector<Num> constants) {
+		return CalcBytecode::try_compile<Num>(ast, * this,
+		                                      std::move(constants));
+	}
+
+template <class Num>
+	Num Calculator<Num>::execute_program(const CalcProgram<Num> & program,
+	                                     bool validate_only, bool set_) {
+		return try_execute_program(program, validate_only, set_).get();
+	}
+
+template <class Num>
+	CalcResult<Num> Calculator<Num>::try_evaluate(const CalcASTElem & ast,
+	                                              bool validate_only,
+	                                              bool set_) {
+		CalcResult<CalcProgram<Num>> program = try_compile(ast);
+
+		if (!program.ok()) {
+			return program.get_error();
+		}
+
+		return try_execute_program(program.get(), validate_only, set_);
+	}
+
+template <class Num>
+	CalcResult<bool> Calculator<Num>::try_validate(
+		const CalcASTElem & ast, const std::vector<Num> * constants) {
+		return CalcValidate::validate(ast, * this, constants);
+	}
+
+template <class Num>
+	void Calculator<Num>::validate(const CalcASTElem & ast,
+	                               const std::vector<Num> * constants) {
+		try_validate(ast, constants).get();
+	}
+
+template <class Num>
+	CalcResult<Num> Calculator<Num>::try_execute_program(
+		const CalcProgram<Num> & program, bool validate_only, bool set_) {
+		auto & binary_ops = CalcOperators<Num>::binary_ops;
+		auto & unary_ops  = CalcOperators<Num>::unary_ops;
+
+		/**
+		 * Intermediate results. Every instruction pushes exactly one value
+		 * or replaces the top ones, so the last value is the result.
+		 */
+		std::vector<Num> stack;
+		stack.reserve(program.max_stack);
+
+		/**
+		 * Programs are bound when they're compiled, but if they're being
+		 * run by a copy of the calculator that compiled them, or functions
+		 * have changed since, the bindings can't be trusted
+		 */
+		bool bound = is_bound(program);
+
+		for (unsigned long i = 0, size = program.code.size(); i < size; i++) {
+			const CalcInstr & instr = program.code[i];
+			const wchar_t   * error = nullptr;
+
+			switch (instr.op) {
+				case OP_CONST:
+					stack.push_back(program.constants[instr.arg]);
+
+					break;
+				case OP_LOAD:
+					if (!variables.is_defined(instr.arg)) {
+						return CalcError(program.spans[i],
+						                 L"Variable doesn't exist");
+					}
+
+					stack.push_back(variables.get(instr.arg));
+
+					break;
+				case OP_STORE:
+					if (!validate_only) {
+						variables.set(instr.arg, stack.back());
+					}
+
+					break;
+				case OP_BINARY: {
+					/**
+					 * Take the right hand side off, the result overwrites the
+					 * left hand side in place
+					 */
+					Num rhs = std::move(stack.back());
+					stack.pop_back();
+
+					error = binary_ops[instr.arg]
+						.kernel(this, stack.back(), rhs, validate_only);
+
+					break;
 				}
+				case OP_UNARY:
+					error = unary_ops[instr.arg]
+						.kernel(this, stack.back(), validate_only);
+
+					break;
+				case OP_CALL: {
+					const CalcASTElem     & call = program.calls[instr.arg];
+					const CalcOpFunc(Num) * func =
+						bound ? program.functions[instr.arg]
+						      : find_function(call.token.data,
+						                      static_cast<unsigned>(
+							                      call.children.size()));
+
+					if (!func) {
+						return CalcError(program.spans[i],
+						                 L"Invalid function call");
+					}
+
+					/**
+					 * The call's arguments refer to this program's constant
+					 * pool. Functions report errors by throwing, including
+					 * ones in their arguments, so this is the one place that
+					 * has to catch.
+					 */
+					try {
+						stack.push_back(call_function(* func, call,
+						                              program.constants,
+						                              validate_only));
+					} catch (CalcASTException & e) {
+						return CalcError(e.get_token(), e.get_msg());
+					}
+
+					break;
+				}
+				case OP_SUM:
+				case OP_PRODUCT: {
+					/**
+					 * The operands are the top of the stack, the result
+					 * overwrites the first one
+					 */
+					const std::vector<bool> & inverse =
+						program.chains[instr.arg];
+					Num * values = & stack[stack.size() - inverse.size()];
+
+					if (instr.op == OP_SUM) {
+						CalcOperations<Num>::NaryKernels::sum(
+							this, values, inverse, validate_only);
+					} else {
+						CalcOperations<Num>::NaryKernels::product(
+							this, values, inverse, validate_only);
+					}
+
+					stack.erase(stack.end() - (inverse.size() - 1),
+					            stack.end());
+
+					break;
+				}
+				case OP_DIVISOR:
+					if (stack.back() == 0) {
+						error = L"Can't divide by 0";
+					}
+
+					break;
 			}
 
-			if (regular_function || variadic_function) {
-				return (* func)(this, ast, validate_only);
-			} else {
-				throw CalcASTException(get_token(ast),
-				                       L"Invalid function call");
+			if (error) {
+				return CalcError(program.spans[i], error);
 			}
-		} else {
-			throw CalcASTException(ast.token, L"Unknown AST element");
 		}
+
+		if (stack.empty()) {
+			return CalcError(Token(), L"Empty program");
+		}
+
+		/**
+		 * Only real results are remembered, validation doesn't do the actual
+		 * math so its result means nothing
+		 */
+		if (set_ && !validate_only) {
+			variables.set(result_slot, stack.back());
+		}
+
+		return std::move(stack.back());
 	}
 
 template <class Num>
@@ -412,12 +755,18 @@ template <class Num>
 	}
 
 template <class Num>
-	std::wstring Calculator<Num>::stringify_ast(const CalcASTElem & ast,
-	                                            const std::wstring & newline) {
+	std::wstring Calculator<Num>::stringify_ast(
+		const CalcASTElem & ast, const std::wstring & newline,
+		const std::vector<Num> * constants) {
 		std::wstring built =
 			             LD::pad(calc_debug_ast.at(ast.type), 10) +
 			             L": " + stringify_tk(ast.token);
 
+		if (constants && ast.type == AST_CONSTANT && ast.constant >= 0 &&
+		    static_cast<unsigned long>(ast.constant) < constants->size()) {
+			built.append(L" = " + to_string((* constants)[ast.constant]));
+		}
+
 		unsigned long children = ast.children.size();
 
 		/**
@@ -427,13 +776,47 @@ template <class Num>
 			built.append(newline + (i == children - 1 ? L"└ " : L"├ ") +
 			             stringify_ast(
 				             ast.children[i],
-				             newline + (i == children - 1 ? L"  " : L"| ")
+				             newline + (i == children - 1 ? L"  " : L"| "),
+				             constants
 			             ));
 		}
 
 		return built;
 	}
 
+template <class Num>
+	std::wstring Calculator<Num>::side_by_side(const std::wstring & left,
+	                                           const std::wstring & right) {
+		std::vector<std::wstring> left_lines, right_lines;
+		std::wstringstream        left_stream(left), right_stream(right);
+		std::wstring              line;
+		unsigned long             width = 0;
+
+		while (std::getline(left_stream, line)) {
+			width = std::max(width, line.length());
+			left_lines.push_back(line);
+		}
+
+		while (std::getline(right_stream, line)) {
+			right_lines.push_back(line);
+		}
+
+		left_lines.resize(std::max(left_lines.size(), right_lines.size()));
+		right_lines.resize(left_lines.size());
+
+		std::wstring built;
+
+		for (unsigned long i = 0; i < left_lines.size(); i++) {
+			built.append(LD::pad(left_lines[i], width + 4) + right_lines[i]);
+
+			if (i < left_lines.size() - 1) {
+				built.append(L"\n");
+			}
+		}
+
+		return built;
+	}
+
 template <class Num>
 	std::wstring Calculator<Num>::execute(const std::wstring & input,
 	                                      bool validate_only) {
@@ -445,8 +828,55 @@ template <class Num>
 			return execute_command_str(input, validate_only);
 		}
 
-		std::vector<Token> tokens = tokenize(input);
-		CalcASTElem        ast    = get_ast(tokens);
+		/**
+		 * Forced debug output is printed while parsing, so it needs the
+		 * expression to actually be parsed
+		 */
+		bool use_cache = expression_cache.get_limit() > 0 &&
+		                 !tk_debug_force && !ast_debug_force;
+
+		CalcExpression<Num> parsed;
+		CalcExpression<Num> * expression = nullptr;
+
+		if (use_cache) {
+			expression = expression_cache.find(input);
+		}
+
+		if (expression) {
+			/**
+			 * Parsing would have complained about this, so complain the same
+			 * way
+			 */
+			if (expression->implicit_last &&
+			    !variables.is_defined(result_slot)) {
+				throw CalcASTException(expression->tokens.front(),
+				                       L"No previous result for implicit"
+				                       L" operation");
+			}
+		} else if (use_cache) {
+			expression = & expression_cache.insert(input, parse(input));
+		} else {
+			parsed     = parse(input);
+			expression = & parsed;
+		}
+
+		/**
+		 * Validation doesn't run anything, so there's nothing to fold or
+		 * bind, and no result to show
+		 */
+		if (validate_only) {
+			validate(expression->folded ? expression->folded_ast
+			                            : expression->ast,
+			         & expression->program.constants);
+
+			return L"";
+		}
+
+		fold(* expression);
+
+		if (!is_bound(expression->program)) {
+			bind(expression->program);
+		}
 
 		/**
 		 * 1. Set the result variable (_) to the result from executing the
@@ -454,20 +884,30 @@ template <class Num>
 		 * 2. Return the value of 1 (which is also the result of executing
 		 *    the string)
 		 */
-		std::wstring result = to_string(execute_ast(ast, validate_only, true));
+		std::wstring result = to_string(
+			execute_program(expression->program, false, true));
 
 		/**
-		 * If AST debug mode is enabled, print the AST
+		 * If AST debug mode is enabled, print the AST, and what folding did
+		 * to it if it's been folded
 		 */
-		if (ast_debug) {
-			result = L"AST:\n" + stringify_ast(ast) + L"\n\n" + result;
+		if (ast_debug && expression->folded) {
+			result = side_by_side(
+				L"AST:\n" + stringify_ast(expression->ast),
+				L"Folded:\n" + stringify_ast(expression->folded_ast, L"\n",
+				                              & expression->program.constants)
+			) + L"\n\n" + result;
+		} else if (ast_debug) {
+			result = L"AST:\n" + stringify_ast(expression->ast) + L"\n\n" +
+			         result;
 		}
 
 		/**
 		 * If TK debug mode is enabled, print the token list
 		 */
 		if (tk_debug) {
-			result = L"Tokens:\n" + stringify_tks(tokens) + L"\n\n" + result;
+			result = L"Tokens:\n" + stringify_tks(expression->tokens) +
+			         L"\n\n" + result;
 		}
 
 		/**
@@ -4,10 +4,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <functional>
 
 #include "CalcASTElem.hpp"
 #include "CalcOpFunc.hpp"
+#include "CalcProgram.hpp"
+#include "CalcExpression.hpp"
+#include "CalcSymbols.hpp"
+#include "CalcResult.hpp"
+#include "LRUCache.hpp"
+#include "FactorialCache.hpp"
 
 /**
  * A CalcCommand stores a function that can be called as a command for the
@@ -87,16 +94,70 @@ template <class Num>
 		 * just uses [[CalcAST::generate_ast]].
 		 *
 		 * @param tokens The tokens to get the AST of.
+		 * @param implicit_last Set to whether the last answer was used
+		 * implicitly, if not `nullptr`.
+		 * @param constants Where to put the parsed number literals, if not
+		 * `nullptr`. Pass this to [[Calculator::compile]] along with the AST.
 		 * @return The AST generated from those tokens.
 		 */
-		CalcASTElem get_ast(std::vector<Token> tokens);
+		CalcASTElem get_ast(std::vector<Token> tokens,
+		                    bool * implicit_last = nullptr,
+		                    std::vector<Num> * constants = nullptr);
+
+		/**
+		 * Bumped by [[Calculator::functions_changed]], so programs bound
+		 * before that can tell they need to be bound again.
+		 */
+		unsigned long functions_version = 0;
+
+		/**
+		 * The constant pool of the program [[Calculator::execute_program]] is
+		 * currently running, if any. Function calls are evaluated with
+		 * [[Calculator::execute_ast]], which reads number literals from here
+		 * instead of parsing them again.
+		 */
+		const std::vector<Num> * constant_pool = nullptr;
+
+		/**
+		 * Previously parsed expressions, keyed by the exact input string.
+		 * Used by [[Calculator::execute]] so that an expression that's been
+		 * seen before only has to be evaluated.
+		 *
+		 * The limit is the number of expressions. Setting it to 0 disables
+		 * the cache.
+		 */
+		LRUCache<std::wstring, CalcExpression<Num>> expression_cache {256};
+
+		/**
+		 * Tokenizes, parses and compiles `input` from scratch. Can throw
+		 * [[CalcASTException]]s.
+		 *
+		 * @param input The expression to parse.
+		 * @return The parsed expression.
+		 */
+		CalcExpression<Num> parse(const std::wstring & input);
+
+		/**
+		 * Runs [[CalcFold::fold]] and then [[CalcFlatten::flatten]] on an
+		 * expression from [[Calculator::parse]] and recompiles it, unless
+		 * that's already been done. This does math, so it's only done once
+		 * the expression is run for real, not when it's only being validated.
+		 *
+		 * @param expression The expression to fold.
+		 */
+		void fold(CalcExpression<Num> & expression);
 
 		public:
 		/**
 		 * The variables. Each variable can only consist of a-z, A-Z, and _. See
 		 * CalcTokenizer.hpp.
 		 */
-		std::map<std::wstring, Num>                                 variables;
+		CalcSymbols<Num> variables;
+
+		/**
+		 * The slot of `_`, the last result
+		 */
+		unsigned result_slot = variables.intern(L"_");
 
 		/**
 		 * Functions the calculator can execute.
@@ -113,6 +174,91 @@ template <class Num>
 		std::map<std::wstring, CalcOpFunc(Num)> variadic_funcs;
 		// @formatter:on
 
+		/**
+		 * Names of functions in [[Calculator::functions]] or
+		 * [[Calculator::variadic_funcs]] that always return the same thing
+		 * for the same arguments and don't touch any variables. Calls to these
+		 * with constant arguments are evaluated ahead of time by
+		 * [[CalcFold::fold]].
+		 *
+		 * If a pure function depends on some setting (like the precision),
+		 * call [[Calculator::invalidate_cache]] when that setting changes.
+		 */
+		std::set<std::wstring> pure_funcs;
+
+		/**
+		 * Names of functions that look at some of their arguments' tokens
+		 * instead of running them, like the `sample`/`population` argument
+		 * of stdvar(). The arguments of every other function are checked
+		 * for variables that don't exist when it's validated (see
+		 * [[CalcValidate::check_arguments]]).
+		 */
+		std::set<std::wstring> raw_funcs;
+
+		/**
+		 * Factorials, double factorials and super factorials worked out so
+		 * far, used by the `!`, `!!` and `$` operators.
+		 */
+		FactorialCache factorial_cache;
+
+		/**
+		 * Finds the function a call to `name` with `arity` arguments would
+		 * run: the one in [[Calculator::functions]] with that arity, or else
+		 * the one in [[Calculator::variadic_funcs]].
+		 *
+		 * @param name The function name
+		 * @param arity The number of arguments
+		 * @return The function, or `nullptr` if there isn't one
+		 */
+		const CalcOpFunc(Num) * find_function(const std::wstring & name,
+		                                      unsigned arity);
+
+		/**
+		 * Calls `func` with `constants` as the constant pool its arguments'
+		 * numbers are read from.
+		 *
+		 * @param func The function
+		 * @param ast The call's AST element
+		 * @param constants The constant pool
+		 * @param validate_only Whether to skip the actual math
+		 * @return What the function returned
+		 */
+		Num call_function(const CalcOpFunc(Num) & func, const CalcASTElem & ast,
+		                  const std::vector<Num> & constants,
+		                  bool validate_only);
+
+		/**
+		 * Resolves every call in `program` to the function it will run, so
+		 * running it doesn't have to look functions up. Done by
+		 * [[Calculator::compile]], and again whenever a program isn't
+		 * [[Calculator::is_bound]] anymore.
+		 *
+		 * Throws a [[CalcASTException]] if a function doesn't exist.
+		 *
+		 * @param program The program to bind
+		 */
+		void bind(CalcProgram<Num> & program);
+
+		/**
+		 * Same as [[Calculator::bind]], but returns errors instead of
+		 * throwing them.
+		 */
+		CalcResult<bool> try_bind(CalcProgram<Num> & program);
+
+		/**
+		 * @return Whether `program` was bound by this calculator, and
+		 * functions haven't changed since
+		 */
+		bool is_bound(const CalcProgram<Num> & program);
+
+		/**
+		 * Call this after changing [[Calculator::functions]] or
+		 * [[Calculator::variadic_funcs]] (other than while setting them up
+		 * in a constructor). Programs will be bound again before they're
+		 * run, and cached expressions are thrown away.
+		 */
+		void functions_changed();
+
 		/**
 		 * Stores all the help pages. Self-explanatory.
 		 */
@@ -177,6 +323,14 @@ template <class Num>
 		 */
 		Calculator();
 
+		/**
+		 * Throws away every cached expression. This must be called after
+		 * changing anything that affects how expressions are parsed or
+		 * compiled, like [[Calculator::functions]],
+		 * [[Calculator::variadic_funcs]] or the operator tables.
+		 */
+		void invalidate_cache();
+
 		/**
 		 * Converts a string to a list of tokens and a command name for use with
 		 * [[Calculator::execute_command]].
@@ -232,12 +386,117 @@ template <class Num>
 		 * It's recursive, so you just call it for whatever element you need. It
 		 * will automatically call itself for all other parts of the expression.
 		 *
+		 * With `validate_only`, nothing is evaluated at all. The AST is checked
+		 * by [[Calculator::validate]] instead, and the value returned means
+		 * nothing. This is how functions check their arguments.
+		 *
 		 * @param ast The AST to execute.
 		 * @return The evaluated result.
 		 */
 		Num execute_ast(const CalcASTElem & ast, bool validate_only = false,
 		                bool set_ = false);
 
+		/**
+		 * Same as [[Calculator::execute_ast]], but numbers are read from
+		 * `constants` (the constant pool the AST's numbers point into) instead
+		 * of being parsed again.
+		 *
+		 * @param ast The AST to execute.
+		 * @param constants The constant pool.
+		 * @param validate_only Whether to skip the actual math.
+		 * @return The evaluated result.
+		 */
+		Num execute_ast(const CalcASTElem & ast,
+		                const std::vector<Num> & constants,
+		                bool validate_only = false);
+
+		/**
+		 * Compiles an AST into a [[CalcProgram]] for
+		 * [[Calculator::execute_program]]. Internally just uses
+		 * [[CalcBytecode::compile]].
+		 *
+		 * This function can throw [[CalcASTException]]s.
+		 *
+		 * @param ast The AST to compile.
+		 * @param constants The constant pool from [[Calculator::get_ast]].
+		 * Numbers that aren't in it are parsed while compiling.
+		 * @return The compiled program.
+		 */
+		CalcProgram<Num> compile(const CalcASTElem & ast,
+		                         std::vector<Num> constants = {});
+
+		/**
+		 * Same as [[Calculator::compile]], but returns errors instead of
+		 * throwing them.
+		 */
+		CalcResult<CalcProgram<Num>> try_compile(
+			const CalcASTElem & ast, std::vector<Num> constants = {});
+
+		/**
+		 * Runs a program from [[Calculator::compile]] and returns the result.
+		 * This gives the same results as [[Calculator::execute_ast]] on the
+		 * AST it was compiled from, but it's a flat loop over the
+		 * instructions instead of a recursive walk over the tree, and it
+		 * doesn't look anything up by name.
+		 *
+		 * @param program The program to run.
+		 * @param validate_only Whether to skip the actual math.
+		 * @param set_ Whether to store the result in `_`.
+		 * @return The evaluated result.
+		 */
+		Num execute_program(const CalcProgram<Num> & program,
+		                    bool validate_only = false, bool set_ = false);
+
+		/**
+		 * Same as [[Calculator::execute_program]], but returns errors
+		 * instead of throwing them. Only errors thrown by functions have to
+		 * be caught; everything else is reported without throwing, so this
+		 * is cheap even when most inputs are wrong.
+		 *
+		 * @param program The program to run.
+		 * @param validate_only Whether to skip the actual math.
+		 * @param set_ Whether to store the result in `_`.
+		 * @return The evaluated result, or what went wrong.
+		 */
+		CalcResult<Num> try_execute_program(const CalcProgram<Num> & program,
+		                                    bool validate_only = false,
+		                                    bool set_ = false);
+
+		/**
+		 * Compiles and runs an AST, reporting errors the same way as
+		 * [[Calculator::try_execute_program]]. For checking input as it's
+		 * typed, [[Calculator::try_validate]] is much cheaper.
+		 *
+		 * @param ast The AST to evaluate.
+		 * @param validate_only Whether to skip the actual math.
+		 * @param set_ Whether to store the result in `_`.
+		 * @return The evaluated result, or what went wrong.
+		 */
+		CalcResult<Num> try_evaluate(const CalcASTElem & ast,
+		                             bool validate_only = false,
+		                             bool set_ = false);
+
+		/**
+		 * Checks whether running an AST would work, without doing any of the
+		 * math. Internally just uses [[CalcValidate::validate]], see there for
+		 * what is and isn't checked.
+		 *
+		 * @param ast The AST to check.
+		 * @param constants The constant pool the AST's numbers point into, or
+		 * `nullptr` to parse them.
+		 * @return `true`, or what's wrong.
+		 */
+		CalcResult<bool> try_validate(const CalcASTElem & ast,
+		                              const std::vector<Num> * constants =
+		                              nullptr);
+
+		/**
+		 * Same as [[Calculator::try_validate]], but throws a
+		 * [[CalcASTException]] if something's wrong.
+		 */
+		void validate(const CalcASTElem & ast,
+		              const std::vector<Num> * constants = nullptr);
+
 		/**
 		 * Generates a string from a token showing its type and data.
 		 *
@@ -259,10 +518,24 @@ template <class Num>
 		 *
 		 * @param ast The AST to stringify
 		 * @param indent Used internally for recursion purposes
+		 * @param constants If not `nullptr`, the values of folded constants
+		 * are looked up here and shown as well
+		 * @return
+		 */
+		std::wstring stringify_ast(
+			const CalcASTElem & ast, const std::wstring & newline = L"\n",
+			const std::vector<Num> * constants = nullptr);
+
+		/**
+		 * Puts two blocks of text next to each other, line by line. Used to
+		 * show ASTs before and after folding.
+		 *
+		 * @param left The left column
+		 * @param right The right column
 		 * @return
 		 */
-		std::wstring stringify_ast(const CalcASTElem & ast,
-		                           const std::wstring & newline = L"\n");
+		std::wstring side_by_side(const std::wstring & left,
+		                          const std::wstring & right);
 
 		/**
 		 * Executes a string. If it's empty, return nothing. If it's a command,
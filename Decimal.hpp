@@ -0,0 +1,271 @@
+#ifndef CALCULATOR_DECIMAL_HPP
+#define CALCULATOR_DECIMAL_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "IntegerMath.hpp"
+#include "Division.hpp"
+#include "Multiplication.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * Converts big integers to decimal strings by divide and conquer.
+ *
+ * Peeling digits off one at a time divides the whole number for each one,
+ * which is quadratic. Instead, a number below 10^(2k) is split into its top
+ * and bottom k digits by dividing by 10^k once, and both halves are
+ * converted the same way. The powers of ten used are 10^19, 10^38, 10^76
+ * and so on, each the square of the last, and they're remembered along with
+ * their reciprocals (see [[Division]]) so every split is a couple of
+ * multiplications. The halves that come out are below 10^19, which fits in
+ * a machine word, and those are written out two digits at a time.
+ *
+ * The strings are exactly what [[math::Unsigned::to_string]],
+ * [[math::Integer::to_string]] and [[math::Rational::to_string]] make, just
+ * sooner.
+ */
+struct Decimal {
+	/**
+	 * Numbers up to this many limbs are left to the library, since
+	 * there's no time to save
+	 */
+	static const size_t threshold = 64;
+
+	private:
+	/**
+	 * How many digits a machine word can always hold
+	 */
+	static const unsigned word_digits = 19;
+
+	struct Power {
+		/**
+		 * 10^(19 * 2^i)
+		 */
+		math::Unsigned value;
+
+		/**
+		 * How many bits `value` has
+		 */
+		size_t bits;
+
+		/**
+		 * [[Division::reciprocal]] of `value`, or 0 until it's needed
+		 */
+		math::Unsigned inverse;
+
+		/**
+		 * How many digits `value` splits off
+		 */
+		size_t digits;
+	};
+
+	static std::vector<Power> & powers() {
+		static std::vector<Power> cache;
+
+		return cache;
+	}
+
+	/**
+	 * @return 10^(19 * 2^i), making it and every power before it if they
+	 * haven't been already. The reference is only good until a higher
+	 * power is made.
+	 */
+	static Power & power(size_t i) {
+		std::vector<Power> & cache = powers();
+
+		while (cache.size() <= i) {
+			Power next;
+
+			if (cache.empty()) {
+				next.value  = IntegerMath::from_word(10000000000000000000ull);
+				next.digits = word_digits;
+			} else {
+				next.value  = Multiplication::multiply(cache.back().value,
+				                                       cache.back().value);
+				next.digits = 2 * cache.back().digits;
+			}
+
+			next.bits = IntegerMath::bit_length(next.value);
+
+			cache.push_back(next);
+		}
+
+		return cache[i];
+	}
+
+	/**
+	 * @return [[Decimal::power]], with its reciprocal worked out
+	 */
+	static Power & divisor(size_t i) {
+		Power & found = power(i);
+
+		if (found.inverse == 0) {
+			found.inverse = Division::reciprocal(found.value, found.bits);
+		}
+
+		return found;
+	}
+
+	/**
+	 * Writes `word`, padded with zeros to `digits` digits, to the end of
+	 * `out`. Digits are worked out in pairs from a table, so there's one
+	 * division for every two of them.
+	 */
+	static void write_word(std::uint64_t word, size_t digits,
+	                       std::string & out) {
+		static const char pairs[] =
+			"00010203040506070809101112131415161718192021222324252627282930"
+			"31323334353637383940414243444546474849505152535455565758596061"
+			"62636465666768697071727374757677787980818283848586878889909192"
+			"93949596979899";
+
+		char   buffer[20];
+		size_t pos = sizeof(buffer);
+
+		while (word >= 100) {
+			std::uint64_t pair = word % 100;
+
+			word /= 100;
+			pos  -= 2;
+
+			buffer[pos]     = pairs[2 * pair];
+			buffer[pos + 1] = pairs[2 * pair + 1];
+		}
+
+		if (word >= 10) {
+			pos -= 2;
+
+			buffer[pos]     = pairs[2 * word];
+			buffer[pos + 1] = pairs[2 * word + 1];
+		} else {
+			buffer[--pos] = static_cast<char>('0' + word);
+		}
+
+		size_t length = sizeof(buffer) - pos;
+
+		if (digits > length) {
+			out.append(digits - length, '0');
+		}
+
+		out.append(buffer + pos, length);
+	}
+
+	/**
+	 * Writes `num`, which is below 10^(19 * 2^level), to the end of `out`.
+	 *
+	 * @param num The number
+	 * @param level Which power of ten is above it
+	 * @param digits How many digits to pad it to with zeros, or 0 to not
+	 * pad it
+	 * @param out Where to write it
+	 */
+	static void write(const math::Unsigned & num, size_t level, size_t digits,
+	                  std::string & out) {
+		if (level == 0) {
+			std::uint64_t word;
+
+			IntegerMath::to_word(num, word);
+			write_word(word, digits, out);
+
+			return;
+		}
+
+		const Power & split = divisor(level - 1);
+
+		if (digits == 0 && num < split.value) {
+			write(num, level - 1, 0, out);
+
+			return;
+		}
+
+		math::Unsigned quotient, remainder;
+
+		Division::divide(num, split.value, split.inverse, split.bits,
+		                 quotient, remainder);
+
+		write(quotient, level - 1,
+		      digits > split.digits ? digits - split.digits : 0, out);
+		write(remainder, level - 1, split.digits, out);
+	}
+
+	public:
+	/**
+	 * @return `num` in decimal
+	 */
+	static std::string to_string(const math::Unsigned & num) {
+		static const math::Unsigned small = math::Unsigned(1) <<
+		                                    (32 * threshold);
+
+		if (num < small) {
+			return num.to_string();
+		}
+
+		size_t level = 0;
+
+		while (!(num < power(level).value)) {
+			level++;
+		}
+
+		std::string out;
+
+		write(num, level, 0, out);
+
+		return out;
+	}
+
+	/**
+	 * @return `num` in decimal, with a `-` in front if it's negative
+	 */
+	static std::string to_string(const math::Integer & num) {
+		std::string magnitude = to_string(num.abs());
+
+		return num < 0 ? "-" + magnitude : magnitude;
+	}
+
+	/**
+	 * `num / den` to `digits` places after the point, rounded half away
+	 * from zero. This is the same string [[math::Rational::to_string]]
+	 * makes, but the division is done by [[Division::divide]] instead of
+	 * long division, and the digits come from the other `to_string`s here.
+	 *
+	 * @param num The numerator
+	 * @param den The denominator, which can't be 0
+	 * @param digits How many digits to put after the point
+	 */
+	static std::string to_string(const math::Integer & num,
+	                             const math::Integer & den, size_t digits) {
+		math::Unsigned scale   = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
+		math::Unsigned divisor = den.abs();
+		math::Unsigned quotient, remainder;
+
+		Division::divide(Multiplication::multiply(num.abs(), scale), divisor,
+		                 quotient, remainder);
+
+		if (!(remainder * 2 < divisor)) {
+			quotient += 1;
+		}
+
+		std::string out = to_string(quotient);
+
+		if (digits > 0) {
+			if (out.size() <= digits) {
+				out.insert(0, digits + 1 - out.size(), '0');
+			}
+
+			out.insert(out.size() - digits, ".");
+		}
+
+		if ((num < 0) != (den < 0) && !(quotient == 0)) {
+			out.insert(0, "-");
+		}
+
+		return out;
+	}
+};
+
+#endif //CALCULATOR_DECIMAL_HPP
@@ -0,0 +1,176 @@
+#ifndef CALCULATOR_DIVISION_HPP
+#define CALCULATOR_DIVISION_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+#include "IntegerMath.hpp"
+#include "Multiplication.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * Division of big integers by multiplying by a reciprocal.
+ *
+ * Long division takes time proportional to the product of the quotient's and
+ * the divisor's lengths. Newton's method finds a reciprocal in about the time
+ * of a few multiplications instead, and [[Multiplication]] does those in
+ * less than quadratic time, so dividing huge numbers this way is much
+ * faster. A reciprocal can also be reused to divide many numbers by the same
+ * divisor.
+ */
+struct Division {
+	/**
+	 * Reciprocals of divisors up to this many bits are found by long
+	 * division
+	 */
+	static const size_t newton_threshold = 128;
+
+	/**
+	 * [[Division::divide]] leaves divisions to the library unless both the
+	 * divisor and the quotient are at least this many bits, since long
+	 * division by a short number, or into a short quotient, is already
+	 * fast
+	 */
+	static const size_t threshold = 2048;
+
+	/**
+	 * floor(2^(2n) / d), which is d's reciprocal scaled up to about n + 1
+	 * bits of precision.
+	 *
+	 * The reciprocal of the top half of d's bits is found first (the same
+	 * way), which is already correct to about half the bits. One Newton
+	 * step, x + x (2^(2n) - d x) / 2^(2n), doubles that, and the result is
+	 * corrected to be exact. Every level of the recursion is half the size
+	 * of the one above it, so the whole thing costs about as much as a few
+	 * multiplications at full size.
+	 *
+	 * @param d The divisor, which can't be 0
+	 * @param n How many bits `d` has, exactly
+	 * @return floor(2^(2n) / d)
+	 */
+	static math::Unsigned reciprocal(const math::Unsigned & d, size_t n) {
+		math::Unsigned scale = math::Unsigned(1) << (2 * n);
+
+		if (n <= newton_threshold) {
+			return scale / d;
+		}
+
+		size_t         m     = n / 2 + 1;
+		math::Unsigned guess = reciprocal(d >> (n - m), m) << (n - m);
+
+		/**
+		 * The guess can be on either side of the real value, so the error
+		 * is signed
+		 */
+		math::Integer  error = math::Integer(scale) -
+		                       math::Integer(Multiplication::multiply(d,
+		                                                              guess));
+		math::Unsigned step  = Multiplication::multiply(guess, error.abs()) >>
+		                       (2 * n);
+		math::Unsigned result = error < 0 ? guess - step - 1 : guess + step;
+
+		/**
+		 * Newton's method lands within a few units, this makes it exact
+		 */
+		math::Integer remainder = math::Integer(scale) -
+		                          math::Integer(Multiplication::multiply(
+			                          d, result));
+
+		while (remainder < 0) {
+			result    -= 1;
+			remainder += math::Integer(d);
+		}
+
+		while (remainder >= math::Integer(d)) {
+			result    += 1;
+			remainder -= math::Integer(d);
+		}
+
+		return result;
+	}
+
+	/**
+	 * Divides `num` by `d` using a reciprocal from
+	 * [[Division::reciprocal]] (Barrett reduction). The quotient it
+	 * estimates is never too big, and at most 2 too small, which is
+	 * corrected.
+	 *
+	 * @param num The dividend, which has to be below 2^(2n)
+	 * @param d The divisor
+	 * @param inverse `reciprocal(d, n)`
+	 * @param n How many bits `d` has
+	 * @param quotient Where to put floor(num / d)
+	 * @param remainder Where to put num mod d
+	 */
+	static void divide(const math::Unsigned & num, const math::Unsigned & d,
+	                   const math::Unsigned & inverse, size_t n,
+	                   math::Unsigned & quotient, math::Unsigned & remainder) {
+		quotient  = Multiplication::multiply(num, inverse) >> (2 * n);
+		remainder = num - Multiplication::multiply(quotient, d);
+
+		while (remainder >= d) {
+			remainder -= d;
+			quotient  += 1;
+		}
+	}
+
+	/**
+	 * Divides `num` by `d`, whatever their sizes.
+	 *
+	 * For a quotient of about k bits, the reciprocal only needs to be good
+	 * to about k bits, so it's found for `d` shifted up to k bits, which is
+	 * floor(2^(n + k) / d). Multiplying by that and shifting back down is
+	 * then exact but for a unit or two, which is corrected.
+	 *
+	 * A short quotient only depends on the top k + 64 or so bits of `d`, and
+	 * the matching bits of `num`, so if `d` is long, just those are divided.
+	 * Rounding `d`'s part up keeps the quotient from being too big, and it's
+	 * at most one too small.
+	 *
+	 * @param num The dividend
+	 * @param d The divisor, which can't be 0
+	 * @param quotient Where to put floor(num / d)
+	 * @param remainder Where to put num mod d
+	 */
+	static void divide(const math::Unsigned & num, const math::Unsigned & d,
+	                   math::Unsigned & quotient, math::Unsigned & remainder) {
+		size_t n      = IntegerMath::bit_length(d);
+		size_t length = IntegerMath::bit_length(num);
+
+		if (length < n + threshold || n < threshold) {
+			size_t keep  = length > n ? length - n + 64 : 64;
+			size_t shift = n > keep ? n - keep : 0;
+
+			if (shift > 0) {
+				quotient = (num >> shift) / ((d >> shift) + 1);
+			} else {
+				quotient = num / d;
+			}
+
+			remainder = num - Multiplication::multiply(quotient, d);
+
+			while (remainder >= d) {
+				remainder -= d;
+				quotient  += 1;
+			}
+
+			return;
+		}
+
+		size_t m = std::max(n, length - n);
+
+		math::Unsigned inverse = reciprocal(d << (m - n), m);
+
+		quotient  = Multiplication::multiply(num, inverse) >> (m + n);
+		remainder = num - Multiplication::multiply(quotient, d);
+
+		while (remainder >= d) {
+			remainder -= d;
+			quotient  += 1;
+		}
+	}
+};
+
+#endif //CALCULATOR_DIVISION_HPP
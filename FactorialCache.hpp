@@ -0,0 +1,406 @@
+#ifndef CALCULATOR_FACTORIALCACHE_HPP
+#define CALCULATOR_FACTORIALCACHE_HPP
+
+#include <set>
+#include <iterator>
+#include <cstdint>
+
+#include "LRUCache.hpp"
+#include "IntegerMath.hpp"
+#include "Multiplication.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+
+/**
+ * Remembers factorials (!), double factorials (!!) and super factorials ($)
+ * so the same ones aren't calculated from scratch over and over.
+ *
+ * Besides the exact values asked for, checkpoints are kept at every
+ * [[FactorialCache::interval]]th value. Asking for a value that isn't cached
+ * continues from the closest cached value below it, so 5500! after 5000! only
+ * multiplies in 5001 through 5500, and leaves a new checkpoint behind if it
+ * passed one. The values cached are indexed in order, so finding that one is
+ * a single lookup.
+ *
+ * Values up to 20 never touch the cache. They're at most a few machine words,
+ * worked out from [[FactorialCache::small]] or multiplied out directly.
+ *
+ * Entries are thrown away least recently used first when they take up more
+ * than [[FactorialCache::get_limit]] bytes. A limit of 0 turns the cache off.
+ */
+class FactorialCache {
+	public:
+	enum Kind {
+		FACTORIAL        = 0,
+		DOUBLE_FACTORIAL = 1,
+		SUPER_FACTORIAL  = 2
+	};
+
+	/**
+	 * Distance between checkpoints
+	 */
+	static const std::uint64_t interval = 1000;
+
+	/**
+	 * Every factorial that fits in a machine word, which is 0! through 20!
+	 *
+	 * @param n At most 20
+	 * @return n!
+	 */
+	static std::uint64_t small(std::uint64_t n) {
+		static const std::uint64_t table[21] = {
+			1ull,
+			1ull,
+			2ull,
+			6ull,
+			24ull,
+			120ull,
+			720ull,
+			5040ull,
+			40320ull,
+			362880ull,
+			3628800ull,
+			39916800ull,
+			479001600ull,
+			6227020800ull,
+			87178291200ull,
+			1307674368000ull,
+			20922789888000ull,
+			355687428096000ull,
+			6402373705728000ull,
+			121645100408832000ull,
+			2432902008176640000ull
+		};
+
+		return table[n];
+	}
+
+	/**
+	 * How many values were worked out with help from the cache, including
+	 * ones that were cached outright. Values up to 20 don't count, as hits
+	 * or misses, since they never touch the cache.
+	 */
+	unsigned long hits = 0;
+
+	/**
+	 * How many values had to be worked out from scratch
+	 */
+	unsigned long misses = 0;
+
+	private:
+	/**
+	 * Keyed by [[FactorialCache::key]]. The cost of every entry is roughly
+	 * its size in bytes.
+	 */
+	LRUCache<std::uint64_t, math::Unsigned> entries;
+
+	/**
+	 * Every n cached, in order, for each of [[FactorialCache::series]].
+	 * Entries [[FactorialCache::entries]] has thrown away are only taken out
+	 * when they're come across.
+	 */
+	std::set<std::uint64_t> index[4];
+
+	static std::uint64_t key(Kind kind, std::uint64_t n) {
+		return n << 2 | kind;
+	}
+
+	/**
+	 * @return Which of [[FactorialCache::index]] n's `kind` goes in. Double
+	 * factorials of odd and even numbers are kept apart, since only values
+	 * of the same parity help each other.
+	 */
+	static size_t series(Kind kind, std::uint64_t n) {
+		return kind == DOUBLE_FACTORIAL && n % 2 ? 3 : kind;
+	}
+
+	/**
+	 * Caches `value` as the `kind` of `n`, if it isn't already and there's
+	 * room for it.
+	 */
+	void store(Kind kind, std::uint64_t n, const math::Unsigned & value) {
+		std::uint64_t k    = key(kind, n);
+		unsigned long cost = IntegerMath::bit_length(value) / 8 + 1;
+
+		if (!entries.contains(k) && entries.fits(cost)) {
+			entries.insert(k, value, cost);
+			index[series(kind, n)].insert(n);
+		}
+	}
+
+	/**
+	 * Finds the closest cached value at or below `n` to continue from.
+	 *
+	 * @param kind What kind of value
+	 * @param n The value that's wanted
+	 * @param floor The largest value that's not worth looking at, because
+	 * it's where continuing starts anyway
+	 * @param found Where to put the value that was found
+	 * @param value Where to put its `kind`
+	 * @return Whether anything was found
+	 */
+	bool closest(Kind kind, std::uint64_t n, std::uint64_t floor,
+	             std::uint64_t & found, math::Unsigned & value) {
+		std::set<std::uint64_t> & cached = index[series(kind, n)];
+
+		auto it = cached.upper_bound(n);
+
+		while (it != cached.begin() && * std::prev(it) > floor) {
+			--it;
+
+			math::Unsigned * entry = entries.find(key(kind, * it));
+
+			if (entry) {
+				found = * it;
+				value = * entry;
+
+				return true;
+			}
+
+			it = cached.erase(it);
+		}
+
+		return false;
+	}
+
+	/**
+	 * @return The last checkpoint at or below `n` with the given parity (0
+	 * or 1), or 0 if there isn't one
+	 */
+	static std::uint64_t checkpoint(std::uint64_t n, std::uint64_t parity) {
+		std::uint64_t c = n / interval * interval + parity;
+
+		if (c > n) {
+			c = c >= interval ? c - interval : 0;
+		}
+
+		return c;
+	}
+
+	/**
+	 * Continues a super factorial from `from$` to `to$`.
+	 *
+	 * to$ is from$ times (from + 1)! through to!, and each of those is from!
+	 * times the numbers after from up to itself. So k, for k after from,
+	 * shows up to + 1 - k times, and from! shows up to - from times.
+	 */
+	math::Unsigned continue_super(std::uint64_t from, const math::Unsigned & sf,
+	                              std::uint64_t to) {
+		if (to <= from) {
+			return sf;
+		}
+
+		std::vector<std::uint64_t> bases, exps;
+
+		for (std::uint64_t k = from + 1; k <= to; k++) {
+			bases.push_back(k);
+			exps.push_back(to + 1 - k);
+		}
+
+		/**
+		 * from! is part of working out the super factorial, not a value of
+		 * its own that was asked for, so it doesn't count as a hit or miss
+		 */
+		unsigned long  outer_hits   = hits;
+		unsigned long  outer_misses = misses;
+		math::Unsigned base         = factorial(from);
+
+		hits   = outer_hits;
+		misses = outer_misses;
+
+		return Multiplication::multiply(
+			Multiplication::multiply(
+				sf, IntegerMath::pow(base, IntegerMath::from_word(to - from))),
+			IntegerMath::power_product(bases, exps));
+	}
+
+	public:
+	/**
+	 * @param limit The memory budget in bytes
+	 */
+	explicit FactorialCache(unsigned long limit = 16 * 1024 * 1024)
+		: entries(limit) {}
+
+	/**
+	 * @return n!
+	 */
+	math::Unsigned factorial(std::uint64_t n) {
+		if (n <= 20) {
+			return IntegerMath::from_word(small(n));
+		} else if (entries.get_limit() == 0) {
+			misses++;
+
+			return IntegerMath::factorial(n);
+		}
+
+		std::uint64_t  from  = 20;
+		math::Unsigned value = IntegerMath::from_word(small(20));
+
+		if (closest(FACTORIAL, n, from, from, value)) {
+			hits++;
+		} else {
+			misses++;
+		}
+
+		std::uint64_t c = checkpoint(n, 0);
+
+		if (c > from) {
+			value = Multiplication::multiply(
+				value, IntegerMath::range_product(from + 1, c));
+			from = c;
+
+			store(FACTORIAL, c, value);
+		}
+
+		if (n > from) {
+			value = Multiplication::multiply(
+				value, IntegerMath::range_product(from + 1, n));
+
+			store(FACTORIAL, n, value);
+		}
+
+		return value;
+	}
+
+	/**
+	 * @return n!!
+	 */
+	math::Unsigned double_factorial(std::uint64_t n) {
+		if (n <= 20) {
+			return IntegerMath::double_factorial(n);
+		} else if (entries.get_limit() == 0) {
+			misses++;
+
+			return IntegerMath::double_factorial(n);
+		}
+
+		std::uint64_t  parity = n % 2;
+		std::uint64_t  from   = 20 - parity;
+		math::Unsigned value  = IntegerMath::double_factorial(from);
+
+		if (closest(DOUBLE_FACTORIAL, n, from, from, value)) {
+			hits++;
+		} else {
+			misses++;
+		}
+
+		std::uint64_t c = checkpoint(n, parity);
+
+		if (c > from) {
+			value = Multiplication::multiply(
+				value, IntegerMath::range_product(from + 2, c, 2));
+			from = c;
+
+			store(DOUBLE_FACTORIAL, c, value);
+		}
+
+		if (n > from) {
+			value = Multiplication::multiply(
+				value, IntegerMath::range_product(from + 2, n, 2));
+
+			store(DOUBLE_FACTORIAL, n, value);
+		}
+
+		return value;
+	}
+
+	/**
+	 * @return n$
+	 */
+	math::Unsigned super_factorial(std::uint64_t n) {
+		if (n <= 20) {
+			std::vector<std::uint64_t> factorials;
+
+			for (std::uint64_t k = 2; k <= n; k++) {
+				factorials.push_back(small(k));
+			}
+
+			return IntegerMath::word_product(factorials);
+		} else if (entries.get_limit() == 0) {
+			misses++;
+
+			return IntegerMath::super_factorial(n);
+		}
+
+		std::uint64_t  from = 0;
+		math::Unsigned value;
+
+		if (closest(SUPER_FACTORIAL, n, from, from, value)) {
+			hits++;
+		} else {
+			/**
+			 * Nothing to continue from, so start over the fast way
+			 */
+			misses++;
+
+			from  = checkpoint(n, 0);
+			from  = from > 20 ? from : n;
+			value = IntegerMath::super_factorial(from);
+
+			store(SUPER_FACTORIAL, from, value);
+		}
+
+		std::uint64_t c = checkpoint(n, 0);
+
+		if (c > from) {
+			value = continue_super(from, value, c);
+			from  = c;
+
+			store(SUPER_FACTORIAL, c, value);
+		}
+
+		if (n > from) {
+			value = continue_super(from, value, n);
+
+			store(SUPER_FACTORIAL, n, value);
+		}
+
+		return value;
+	}
+
+	/**
+	 * Sets the memory budget in bytes, evicting entries if the cache is now
+	 * over it. 0 turns the cache off.
+	 */
+	void set_limit(unsigned long limit) {
+		entries.set_limit(limit);
+
+		if (limit == 0) {
+			clear();
+		}
+	}
+
+	/**
+	 * @return The memory budget in bytes
+	 */
+	unsigned long get_limit() const {
+		return entries.get_limit();
+	}
+
+	/**
+	 * @return Roughly how many bytes are in use
+	 */
+	unsigned long get_used() const {
+		return entries.get_used();
+	}
+
+	/**
+	 * @return How many values are cached
+	 */
+	unsigned long size() const {
+		return entries.size();
+	}
+
+	/**
+	 * Forgets every value. The hit and miss counters are kept.
+	 */
+	void clear() {
+		entries.clear();
+
+		for (std::set<std::uint64_t> & cached : index) {
+			cached.clear();
+		}
+	}
+};
+
+#endif //CALCULATOR_FACTORIALCACHE_HPP
@@ -0,0 +1,402 @@
+#ifndef CALCULATOR_HYBRIDRATIONAL_HPP
+#define CALCULATOR_HYBRIDRATIONAL_HPP
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include "IntegerMath.hpp"
+#include "Multiplication.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * A rational number that's a pair of machine words for as long as it fits in
+ * one, and a [[math::Rational]] when it doesn't.
+ *
+ * Most of what gets typed into a calculator is small. A [[math::Rational]]
+ * allocates for every number and every operation, even for 2 + 2, while two
+ * machine words are just added. Every operation on small numbers checks for
+ * overflow, and if there is any, does the operation again as a
+ * [[math::Rational]]. Results that fit are turned back into machine words,
+ * so a large number in the middle of a calculation doesn't make everything
+ * after it slow.
+ *
+ * Small values are kept in lowest terms with a positive denominator, just
+ * like a [[math::Rational]] would be. Neither word is ever INT64_MIN, so
+ * either can be negated safely.
+ */
+class HybridRational {
+	/**
+	 * The numerator, if [[HybridRational::big]] is null
+	 */
+	std::int64_t num = 0;
+
+	/**
+	 * The denominator, if [[HybridRational::big]] is null
+	 */
+	std::int64_t den = 1;
+
+	/**
+	 * The value, if it doesn't fit in [[HybridRational::num]] and
+	 * [[HybridRational::den]]. Never changed once it's set, so copies can
+	 * share it.
+	 */
+	std::shared_ptr<const math::Rational> big;
+
+	static std::uint64_t gcd(std::uint64_t a, std::uint64_t b) {
+		while (b != 0) {
+			std::uint64_t t = a % b;
+
+			a = b;
+			b = t;
+		}
+
+		return a;
+	}
+
+	static std::uint64_t magnitude(std::int64_t n) {
+		return n < 0 ? -static_cast<std::uint64_t>(n)
+		             : static_cast<std::uint64_t>(n);
+	}
+
+	/**
+	 * @return `n` as a [[math::Integer]]
+	 */
+	static math::Integer to_integer(std::int64_t n) {
+		math::Integer result(IntegerMath::from_word(magnitude(n)));
+
+		return n < 0 ? -result : result;
+	}
+
+	/**
+	 * Gets the magnitude of `n` as a machine word, if it's small enough to
+	 * be one of the words of a small value.
+	 */
+	static bool to_small(const math::Integer & n, std::int64_t & word) {
+		std::uint64_t result;
+
+		if (!IntegerMath::to_word(n.abs(), result) || result > INT64_MAX) {
+			return false;
+		}
+
+		word = static_cast<std::int64_t>(result);
+
+		return true;
+	}
+
+	/**
+	 * a/b + c/d, as in Knuth's TAOCP 4.5.1. Dividing by the GCD of the
+	 * denominators first keeps the intermediate results small, and only
+	 * that GCD needs to be checked to get the result in lowest terms.
+	 *
+	 * @return Whether the result fit
+	 */
+	static bool add(std::int64_t a, std::int64_t b, std::int64_t c,
+	                std::int64_t d, std::int64_t & n, std::int64_t & m) {
+		std::int64_t g  = static_cast<std::int64_t>(gcd(b, d));
+		std::int64_t bg = b / g;
+		std::int64_t dg = d / g;
+		std::int64_t x, y, t;
+
+		if (__builtin_mul_overflow(a, dg, & x) ||
+		    __builtin_mul_overflow(c, bg, & y) ||
+		    __builtin_add_overflow(x, y, & t) || t == INT64_MIN) {
+			return false;
+		}
+
+		if (t == 0) {
+			n = 0;
+			m = 1;
+
+			return true;
+		}
+
+		std::int64_t g2 = static_cast<std::int64_t>(gcd(magnitude(t), g));
+
+		if (__builtin_mul_overflow(bg, d / g2, & m)) {
+			return false;
+		}
+
+		n = t / g2;
+
+		return true;
+	}
+
+	/**
+	 * a/b * c/d. a and d have no common factors with each other once they
+	 * are divided by their GCD, and same for c and b, so the result is
+	 * already in lowest terms.
+	 *
+	 * @return Whether the result fit
+	 */
+	static bool multiply(std::int64_t a, std::int64_t b, std::int64_t c,
+	                     std::int64_t d, std::int64_t & n, std::int64_t & m) {
+		if (a == 0 || c == 0) {
+			n = 0;
+			m = 1;
+
+			return true;
+		}
+
+		std::int64_t g1 = static_cast<std::int64_t>(gcd(magnitude(a), d));
+		std::int64_t g2 = static_cast<std::int64_t>(gcd(magnitude(c), b));
+
+		return !__builtin_mul_overflow(a / g1, c / g2, & n) &&
+		       n != INT64_MIN &&
+		       !__builtin_mul_overflow(b / g2, d / g1, & m);
+	}
+
+	/**
+	 * Compares a/b with c/d by cross multiplying.
+	 *
+	 * @return Whether the comparison could be done without overflowing
+	 */
+	static bool cross_compare(std::int64_t a, std::int64_t b, std::int64_t c,
+	                          std::int64_t d, int & result) {
+		std::int64_t x, y;
+
+		if (__builtin_mul_overflow(a, d, & x) ||
+		    __builtin_mul_overflow(c, b, & y)) {
+			return false;
+		}
+
+		result = x < y ? -1 : x > y ? 1 : 0;
+
+		return true;
+	}
+
+	/**
+	 * @return -1, 0 or 1 if this is less than, equal to or greater than
+	 * `rhs`
+	 */
+	int compare(const HybridRational & rhs) const {
+		int result;
+
+		if (!big && !rhs.big &&
+		    cross_compare(num, den, rhs.num, rhs.den, result)) {
+			return result;
+		}
+
+		math::Rational lhs_value = to_rational();
+		math::Rational rhs_value = rhs.to_rational();
+
+		return lhs_value < rhs_value ? -1 : rhs_value < lhs_value ? 1 : 0;
+	}
+
+	public:
+	HybridRational() = default;
+
+	HybridRational(int value) : num(value) {}
+
+	HybridRational(double value) : HybridRational(math::Rational(value)) {}
+
+	/**
+	 * Parses a number. Plain integers short enough that they can't overflow
+	 * are parsed directly, anything else is left to [[math::Rational]], so
+	 * invalid numbers fail in the same way.
+	 */
+	explicit HybridRational(const std::string & str) {
+		if (!str.empty() && str.length() <= 18 &&
+		    str.find_first_not_of("0123456789") == std::string::npos) {
+			for (char c : str) {
+				num = num * 10 + (c - '0');
+			}
+		} else {
+			* this = math::Rational(str);
+		}
+	}
+
+	/**
+	 * Turns `value` back into machine words if it fits in them.
+	 */
+	HybridRational(const math::Rational & value) {
+		std::int64_t n, d;
+
+		if (to_small(value.numerator(), n) &&
+		    to_small(value.denominator(), d)) {
+			bool negative = (value.numerator() < 0) !=
+			                (value.denominator() < 0);
+
+			num = negative ? -n : n;
+			den = d;
+		} else {
+			big = std::make_shared<const math::Rational>(value);
+		}
+	}
+
+	/**
+	 * @return This value as a [[math::Rational]]
+	 */
+	math::Rational to_rational() const {
+		if (big) {
+			return * big;
+		}
+
+		return math::Rational(to_integer(num), to_integer(den));
+	}
+
+	explicit operator math::Rational() const {
+		return to_rational();
+	}
+
+	math::Integer numerator() const {
+		return big ? big->numerator() : to_integer(num);
+	}
+
+	math::Integer denominator() const {
+		return big ? big->denominator() : to_integer(den);
+	}
+
+	HybridRational & operator+=(const HybridRational & rhs) {
+		std::int64_t n, m;
+
+		if (!big && !rhs.big && add(num, den, rhs.num, rhs.den, n, m)) {
+			num = n;
+			den = m;
+
+			return * this;
+		}
+
+		return * this = to_rational() + rhs.to_rational();
+	}
+
+	HybridRational & operator-=(const HybridRational & rhs) {
+		std::int64_t n, m;
+
+		if (!big && !rhs.big && add(num, den, -rhs.num, rhs.den, n, m)) {
+			num = n;
+			den = m;
+
+			return * this;
+		}
+
+		return * this = to_rational() - rhs.to_rational();
+	}
+
+	HybridRational & operator*=(const HybridRational & rhs) {
+		std::int64_t n, m;
+
+		if (!big && !rhs.big && multiply(num, den, rhs.num, rhs.den, n, m)) {
+			num = n;
+			den = m;
+
+			return * this;
+		}
+
+		return * this = Multiplication::multiply(to_rational(),
+		                                         rhs.to_rational());
+	}
+
+	/**
+	 * Dividing by 0 is left to [[math::Rational]], so it fails the same
+	 * way.
+	 */
+	HybridRational & operator/=(const HybridRational & rhs) {
+		std::int64_t n, m;
+
+		if (!big && !rhs.big && rhs.num != 0 &&
+		    multiply(num, den, rhs.num < 0 ? -rhs.den : rhs.den,
+		             magnitude(rhs.num), n, m)) {
+			num = n;
+			den = m;
+
+			return * this;
+		}
+
+		return * this = Multiplication::divide(to_rational(),
+		                                       rhs.to_rational());
+	}
+
+	HybridRational operator-() const {
+		if (big) {
+			return -* big;
+		}
+
+		HybridRational result = * this;
+
+		result.num = -num;
+
+		return result;
+	}
+
+	HybridRational operator+(const HybridRational & rhs) const {
+		HybridRational result = * this;
+
+		return result += rhs;
+	}
+
+	HybridRational operator-(const HybridRational & rhs) const {
+		HybridRational result = * this;
+
+		return result -= rhs;
+	}
+
+	HybridRational operator*(const HybridRational & rhs) const {
+		HybridRational result = * this;
+
+		return result *= rhs;
+	}
+
+	HybridRational operator/(const HybridRational & rhs) const {
+		HybridRational result = * this;
+
+		return result /= rhs;
+	}
+
+	bool operator==(const HybridRational & rhs) const {
+		if (!big && !rhs.big) {
+			return num == rhs.num && den == rhs.den;
+		}
+
+		return compare(rhs) == 0;
+	}
+
+	bool operator!=(const HybridRational & rhs) const {
+		return !(* this == rhs);
+	}
+
+	bool operator<(const HybridRational & rhs) const {
+		return compare(rhs) < 0;
+	}
+
+	bool operator>(const HybridRational & rhs) const {
+		return compare(rhs) > 0;
+	}
+
+	bool operator<=(const HybridRational & rhs) const {
+		return compare(rhs) <= 0;
+	}
+
+	bool operator>=(const HybridRational & rhs) const {
+		return compare(rhs) >= 0;
+	}
+
+	/**
+	 * The string functions are [[math::Rational]]'s, so the output is
+	 * exactly the same. Integers are the exception, since there's only one
+	 * way to write those.
+	 */
+	std::string to_string() const {
+		if (!big && den == 1) {
+			return std::to_string(num);
+		}
+
+		return to_rational().to_string();
+	}
+
+	std::string to_string(size_t digits) const {
+		return to_rational().to_string(digits);
+	}
+
+	std::string to_precise_string() const {
+		if (!big && den == 1) {
+			return std::to_string(num);
+		}
+
+		return to_rational().to_precise_string();
+	}
+};
+
+#endif //CALCULATOR_HYBRIDRATIONAL_HPP
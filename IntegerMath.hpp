@@ -0,0 +1,416 @@
+#ifndef CALCULATOR_INTEGERMATH_HPP
+#define CALCULATOR_INTEGERMATH_HPP
+
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include "Multiplication.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+
+/**
+ * Exact math on integers. The operators work on [[math::Rational]]s, which
+ * keep themselves in lowest terms after every operation. That costs a GCD
+ * each time, which is a waste when the numbers involved are known to be
+ * integers (or known to stay in lowest terms), so the heavy lifting happens
+ * here instead and the result is turned into a [[math::Rational]] once.
+ */
+struct IntegerMath {
+	/**
+	 * Below this many factors, [[IntegerMath::product]] and
+	 * [[IntegerMath::power_product]] don't split their work across threads
+	 */
+	static const size_t parallel_factors = 256;
+
+	/**
+	 * Square-and-multiply: walks the bits of `exp` from the top, squaring
+	 * for every bit and multiplying by `base` for every set bit. That's
+	 * about log2(exp) squarings instead of `exp` multiplications, and the
+	 * number being multiplied in is always just `base`.
+	 *
+	 * @tparam Int [[math::Integer]] or [[math::Unsigned]]
+	 * @param base The base
+	 * @param exp The exponent
+	 * @return `base` to the power of `exp`
+	 */
+	template <class Int>
+		static Int pow(const Int & base, math::Unsigned exp) {
+			if (exp == 0) {
+				return 1;
+			}
+
+			/**
+			 * Least significant first
+			 */
+			std::vector<bool> bits;
+
+			while (exp > 0) {
+				bits.push_back(exp % 2 == 1);
+				exp >>= 1;
+			}
+
+			/**
+			 * The top bit is always set, which is where the result starts
+			 */
+			Int result = base;
+
+			for (size_t i = bits.size() - 1; i-- > 0;) {
+				result = Multiplication::multiply(result, result);
+
+				if (bits[i]) {
+					result = Multiplication::multiply(result, base);
+				}
+			}
+
+			return result;
+		}
+
+	/**
+	 * @param word Any machine word
+	 * @return `word` as a [[math::Unsigned]]
+	 */
+	static math::Unsigned from_word(std::uint64_t word) {
+		math::Unsigned result(static_cast<math::Unsigned::Digit>(word >> 32));
+
+		result <<= 32;
+		result += static_cast<math::Unsigned::Digit>(word);
+
+		return result;
+	}
+
+	/**
+	 * @return How many bits it takes to write `num`, 0 for 0
+	 */
+	static size_t bit_length(const math::Unsigned & num) {
+		if (num == 0) {
+			return 0;
+		}
+
+		/**
+		 * Find a shift that clears everything, then binary search between
+		 * it and the last one that didn't
+		 */
+		size_t hi = 1;
+
+		while ((num >> hi) > 0) {
+			hi *= 2;
+		}
+
+		size_t lo = hi / 2;
+
+		while (hi - lo > 1) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if ((num >> mid) > 0) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return hi;
+	}
+
+	/**
+	 * Gets `num` as a machine word, if it fits in one.
+	 *
+	 * @param num The number
+	 * @param word Where to put it
+	 * @return Whether it fit
+	 */
+	static bool to_word(const math::Unsigned & num, std::uint64_t & word) {
+		if ((num >> 64) > 0) {
+			return false;
+		}
+
+		word = static_cast<std::uint64_t>((num >> 32).to_uint()) << 32 |
+		       (num - ((num >> 32) << 32)).to_uint();
+
+		return true;
+	}
+
+	/**
+	 * Multiplies `factor` into `word`, first moving `word` to the end of
+	 * `words` if the result wouldn't fit.
+	 */
+	static void multiply_word(std::vector<math::Unsigned> & words,
+	                          std::uint64_t & word, std::uint64_t factor) {
+		if (word > UINT64_MAX / factor) {
+			words.push_back(from_word(word));
+			word = 1;
+		}
+
+		word *= factor;
+	}
+
+	/**
+	 * Moves what's left in `word` to `words` and multiplies them all.
+	 */
+	static math::Unsigned finish_words(std::vector<math::Unsigned> & words,
+	                                   std::uint64_t word) {
+		if (word > 1 || words.empty()) {
+			words.push_back(from_word(word));
+		}
+
+		return product(words);
+	}
+
+	/**
+	 * Multiplies `factors[begin]` through `factors[end - 1]` as a balanced
+	 * tree: the two halves are multiplied separately, then together. Both
+	 * sides of every multiplication are then about the same size, which is
+	 * where multiplication algorithms do best, instead of one huge number
+	 * being multiplied by a tiny one over and over.
+	 *
+	 * The halves of big enough trees are worked out at the same time, and
+	 * those halves split the same way, so the tree ends up in chunks across
+	 * the threads [[Multiplication]] uses. Idle threads steal the biggest
+	 * chunks that are left, and partial products are merged in pairs as
+	 * soon as both are done. The tree has the same shape either way, so the
+	 * result doesn't depend on how many threads there are.
+	 *
+	 * @param factors The numbers to multiply
+	 * @param begin The first one
+	 * @param end One past the last one
+	 * @return Their product, 1 if there are none
+	 */
+	static math::Unsigned product(const std::vector<math::Unsigned> & factors,
+	                              size_t begin, size_t end) {
+		if (begin >= end) {
+			return 1;
+		} else if (end - begin == 1) {
+			return factors[begin];
+		} else if (end - begin == 2) {
+			return Multiplication::multiply(factors[begin], factors[begin + 1]);
+		}
+
+		size_t mid = begin + (end - begin) / 2;
+
+		if (end - begin < parallel_factors) {
+			return Multiplication::multiply(product(factors, begin, mid),
+			                                product(factors, mid, end));
+		}
+
+		math::Unsigned lo, hi;
+
+		Multiplication::run({
+			[&]() {
+				lo = product(factors, begin, mid);
+			},
+			[&]() {
+				hi = product(factors, mid, end);
+			}
+		});
+
+		return Multiplication::multiply(lo, hi);
+	}
+
+	/**
+	 * @return The product of every number in `factors`
+	 */
+	static math::Unsigned product(const std::vector<math::Unsigned> & factors) {
+		return product(factors, 0, factors.size());
+	}
+
+	/**
+	 * Multiplies `lo`, `lo + step`, `lo + 2 * step`, and so on, up to
+	 * and including `hi` if it's in there.
+	 *
+	 * Runs of small factors are multiplied as machine words first, and only
+	 * those words go into [[IntegerMath::product]], so there are far fewer
+	 * big number multiplications than there are factors.
+	 *
+	 * @param lo The first factor
+	 * @param hi The largest factor there can be
+	 * @param step The distance between factors
+	 * @return The product, 1 if there are no factors
+	 */
+	static math::Unsigned range_product(std::uint64_t lo, std::uint64_t hi,
+	                                    std::uint64_t step = 1) {
+		if (lo == 0) {
+			return 0;
+		}
+
+		std::vector<math::Unsigned> words;
+		std::uint64_t               word = 1;
+
+		/**
+		 * `i >= lo` stops it from wrapping around past the largest word
+		 */
+		for (std::uint64_t i = lo; i <= hi && i >= lo; i += step) {
+			multiply_word(words, word, i);
+		}
+
+		return finish_words(words, word);
+	}
+
+	/**
+	 * Same as [[IntegerMath::range_product]], but for any list of factors.
+	 *
+	 * @param factors The factors, none of which may be 0
+	 * @return The product, 1 if there are no factors
+	 */
+	static math::Unsigned word_product(
+		const std::vector<std::uint64_t> & factors) {
+		std::vector<math::Unsigned> words;
+		std::uint64_t               word = 1;
+
+		for (std::uint64_t factor : factors) {
+			multiply_word(words, word, factor);
+		}
+
+		return finish_words(words, word);
+	}
+
+	/**
+	 * @return n!
+	 */
+	static math::Unsigned factorial(std::uint64_t n) {
+		return range_product(2, n);
+	}
+
+	/**
+	 * @return n!!, which is n * (n - 2) * (n - 4) * ..., down to 1 or 2
+	 */
+	static math::Unsigned double_factorial(std::uint64_t n) {
+		return range_product(n % 2 ? 1 : 2, n, 2);
+	}
+
+	/**
+	 * Sieve of Eratosthenes.
+	 *
+	 * @return Every prime up to and including `n`
+	 */
+	static std::vector<std::uint64_t> primes(std::uint64_t n) {
+		std::vector<std::uint64_t> found;
+
+		if (n < 2) {
+			return found;
+		}
+
+		std::vector<bool> composite(n + 1, false);
+
+		for (std::uint64_t i = 2; i <= n; i++) {
+			if (composite[i]) {
+				continue;
+			}
+
+			found.push_back(i);
+
+			for (std::uint64_t j = i * i; j <= n && i <= n / i; j += i) {
+				composite[j] = true;
+			}
+		}
+
+		return found;
+	}
+
+	/**
+	 * Multiplies `bases[i]` to the power of `exps[i]` for every `i`.
+	 *
+	 * Rather than raising every base separately, the bases whose exponents
+	 * have a given bit set are multiplied together first, and those
+	 * products are combined by square-and-multiply (see
+	 * [[IntegerMath::pow]]). That's one squaring per bit of the largest
+	 * exponent in total, instead of per base.
+	 *
+	 * @param bases The bases, none of which may be 0
+	 * @param exps Their exponents
+	 * @return The product
+	 */
+	static math::Unsigned power_product(
+		const std::vector<std::uint64_t> & bases,
+		const std::vector<std::uint64_t> & exps) {
+		std::uint64_t largest = 0;
+
+		for (std::uint64_t exp : exps) {
+			if (exp > largest) {
+				largest = exp;
+			}
+		}
+
+		unsigned bits = 0;
+
+		while (bits < 64 && largest >> bits) {
+			bits++;
+		}
+
+		/**
+		 * The products for each bit don't depend on each other, so they're
+		 * worked out up front, at the same time if there are enough bases
+		 */
+		std::vector<math::Unsigned>        products(bits);
+		std::vector<std::function<void()>> jobs;
+
+		for (unsigned bit = 0; bit < bits; bit++) {
+			jobs.push_back([&, bit]() {
+				std::vector<std::uint64_t> factors;
+
+				for (size_t i = 0; i < bases.size(); i++) {
+					if (exps[i] >> bit & 1) {
+						factors.push_back(bases[i]);
+					}
+				}
+
+				products[bit] = word_product(factors);
+			});
+		}
+
+		if (bases.size() >= parallel_factors) {
+			Multiplication::run(jobs);
+		} else {
+			for (const std::function<void()> & job : jobs) {
+				job();
+			}
+		}
+
+		math::Unsigned result = 1;
+
+		for (unsigned bit = bits; bit-- > 0;) {
+			result = Multiplication::multiply(result, result);
+			result = Multiplication::multiply(result, products[bit]);
+		}
+
+		return result;
+	}
+
+	/**
+	 * The super factorial, which is 1! * 2! * ... * n!.
+	 *
+	 * Every k from 2 to n shows up in n + 1 - k of those factorials, so it's
+	 * the product of k^(n + 1 - k). Split into primes, the exponent of p is
+	 * the sum of (n + 1 - k) over every k that's a multiple of p, plus the
+	 * same for p^2, p^3 and so on. Each of those sums has a closed form, and
+	 * [[IntegerMath::power_product]] takes care of the rest.
+	 *
+	 * @return n$
+	 */
+	static math::Unsigned super_factorial(std::uint64_t n) {
+		std::vector<std::uint64_t> bases = primes(n);
+		std::vector<std::uint64_t> exps;
+
+		for (std::uint64_t p : bases) {
+			std::uint64_t exp = 0;
+
+			for (std::uint64_t q = p; q <= n; q *= p) {
+				/**
+				 * Sum of (n + 1 - m * q) for m from 1 to n / q
+				 */
+				std::uint64_t m = n / q;
+
+				exp += m * (n + 1) - q * (m * (m + 1) / 2);
+
+				if (q > n / p) {
+					break;
+				}
+			}
+
+			exps.push_back(exp);
+		}
+
+		return power_product(bases, exps);
+	}
+};
+
+#endif //CALCULATOR_INTEGERMATH_HPP
@@ -3,144 +3,567 @@
 
 #include <iostream>
 #include <string>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#include "Division.hpp"
+#include "IntegerMath.hpp"
+#include "Multiplication.hpp"
 
 #include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
 
 struct Irrational {
 	/**
-	 * Source: https://rosettacode.org/wiki/Pi#C.23
+	 * Square roots of numbers up to this many bits are found by plain
+	 * Newton's method
 	 */
-	struct PiCalculator {
-		math::Integer k  = 1,
-		              l  = 3,
-		              n  = 0,
-		              q  = 10,
-		              r  = -30,
-		              t  = 1,
-		              nr = -30;
+	static const size_t sqrt_threshold = 256;
 
-		public:
+	/**
+	 * Ranges of at least this many series terms have their halves worked
+	 * out at the same time
+	 */
+	static const size_t parallel_terms = 256;
+
+	/**
+	 * floor(sqrt(num)), by Newton's method with precision doubling.
+	 *
+	 * The root of the top half of `num`'s bits is found first (the same
+	 * way), which is the top half of the root's bits, give or take one. A
+	 * single Newton step from there, (x + num / x) / 2, is then good to
+	 * within a unit or so, and never too small, so it's stepped down until
+	 * it's exact. Every level of the recursion is half the size of the one
+	 * above it, so the whole thing costs about as much as one division at
+	 * full size.
+	 *
+	 * @param num The number
+	 * @return The largest number whose square isn't above `num`
+	 */
+	static math::Unsigned isqrt(const math::Unsigned & num) {
+		size_t bits = IntegerMath::bit_length(num);
+
+		if (bits <= sqrt_threshold) {
+			if (num == 0) {
+				return 0;
+			}
+
+			/**
+			 * Starts above the root, and comes down until it stops
+			 * moving
+			 */
+			math::Unsigned root = math::Unsigned(1) << ((bits + 1) / 2);
 
-		/**
-		 * Gets the next digit of pi.
-		 *
-		 * I don't understand how this works, I'm just afraid to touch it.
-		 *
-		 * @return
-		 */
-		math::Unsigned next_digit() {
 			while (true) {
-				math::Integer tn = t * n;
-
-				if (4 * q + r - t < tn) {
-					math::Integer nn = n;
-					nr = (r - tn) * 10;
-					n  = (q * 3 + r) * 10 / t - 10 * n;
-					q *= 10;
-					r  = nr;
-
-					return nn.abs();
-				} else {
-					t *= l;
-					nr = (q * 2 + r) * l;
-					n  = (q * (k * 7) + 2 + r * l) / t;
-					q *= k;
-					l += 2;
-					k++;
+				math::Unsigned next = (root + num / root) >> 1;
+
+				if (!(next < root)) {
+					return root;
 				}
 
-				r = nr;
+				root = next;
 			}
 		}
 
-		PiCalculator() = default;
+		size_t         shift = bits / 4 - 1;
+		math::Unsigned guess = isqrt(num >> (2 * shift)) << shift;
+		math::Unsigned quotient, remainder;
+
+		Division::divide(num, guess, quotient, remainder);
+
+		math::Unsigned root   = (guess + quotient) >> 1;
+		math::Unsigned square = Multiplication::multiply(root, root);
+
+		while (square > num) {
+			square -= (root << 1) - 1;
+			root   -= 1;
+		}
+
+		return root;
+	}
+
+	/**
+	 * The sums that binary splitting works with, for a range of series
+	 * terms [a, b). For the Chudnovsky series, P and Q are the products of
+	 * the numerators and denominators of the ratios between terms, and T is
+	 * the range's part of the sum, times Q(0, b). For e, P over Q is the
+	 * range's part of the sum, times a!, and T isn't used.
+	 */
+	struct Split {
+		math::Unsigned p;
+		math::Unsigned q;
+		math::Integer  t;
 	};
 
+	/**
+	 * Binary splitting for the Chudnovsky series,
+	 *
+	 *   1/pi = 12 sum((-1)^k (6k)! (13591409 + 545140134k) /
+	 *                 ((3k)! (k!)^3 640320^(3k + 3/2)))
+	 *
+	 * which gets about 14 more digits with every term. Instead of adding up
+	 * fractions, the range is split in two, both halves are worked out the
+	 * same way, and they're combined with a few multiplications, so the
+	 * numbers being multiplied are always about the same size. Big enough
+	 * ranges have their halves worked out on different threads.
+	 *
+	 * @param a The first term
+	 * @param b One past the last term
+	 * @return P, Q and T for the range
+	 */
+	static Split chudnovsky(std::uint64_t a, std::uint64_t b) {
+		Split split;
+
+		if (b - a == 1) {
+			if (a == 0) {
+				split.p = 1;
+				split.q = 1;
+			} else {
+				math::Unsigned k = IntegerMath::from_word(a);
+
+				split.p = IntegerMath::from_word(6 * a - 5) *
+				          IntegerMath::from_word(2 * a - 1) *
+				          IntegerMath::from_word(6 * a - 1);
+
+				/**
+				 * 640320^3 / 24
+				 */
+				split.q = k * k * k *
+				          IntegerMath::from_word(10939058860032000ull);
+			}
+
+			split.t = math::Integer(
+				split.p * (IntegerMath::from_word(13591409) +
+				           IntegerMath::from_word(545140134) *
+				           IntegerMath::from_word(a)));
+
+			if (a % 2 == 1) {
+				split.t = -split.t;
+			}
+
+			return split;
+		}
+
+		std::uint64_t mid = a + (b - a) / 2;
+		Split         lo, hi;
+
+		if (b - a < parallel_terms) {
+			lo = chudnovsky(a, mid);
+			hi = chudnovsky(mid, b);
+		} else {
+			Multiplication::run({
+				[&]() {
+					lo = chudnovsky(a, mid);
+				},
+				[&]() {
+					hi = chudnovsky(mid, b);
+				}
+			});
+		}
+
+		split.p = Multiplication::multiply(lo.p, hi.p);
+		split.q = Multiplication::multiply(lo.q, hi.q);
+		split.t = Multiplication::multiply(lo.t, math::Integer(hi.q)) +
+		          Multiplication::multiply(math::Integer(lo.p), hi.t);
+
+		return split;
+	}
+
+	/**
+	 * floor(pi * 10^digits), from the Chudnovsky series.
+	 *
+	 * With the series summed by [[Irrational::chudnovsky]], pi is
+	 * 426880 sqrt(10005) Q / T, which is worked out as a fixed-point number
+	 * with 64 extra bits and a single division. That's within a couple of
+	 * units of the last extra bit, so unless the extra bits are right next
+	 * to rolling over, dropping them gives exactly the digits wanted. If
+	 * they are, it's done again with more extra bits.
+	 *
+	 * @param digits How many digits after the point
+	 * @return pi's digits, up to and including the `digits`th one after
+	 * the point
+	 */
+	static math::Unsigned pi_digits(size_t digits) {
+		math::Unsigned decimal = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
+
+		for (size_t guard = 64;; guard *= 2) {
+			/**
+			 * Every term is worth a little over 14 digits, and counting
+			 * every guard bit as a digit leaves plenty to spare
+			 */
+			Split sum = chudnovsky(0, (digits + guard) / 14 + 2);
+
+			math::Unsigned scale = decimal << guard;
+			math::Unsigned root  = isqrt(IntegerMath::from_word(10005) *
+			                             Multiplication::multiply(scale,
+			                                                      scale));
+			math::Unsigned num   = Multiplication::multiply(
+				IntegerMath::from_word(426880) * root, sum.q);
+			math::Unsigned fixed, remainder;
+
+			Division::divide(num, sum.t.abs(), fixed, remainder);
+
+			math::Unsigned result = fixed >> guard;
+			math::Unsigned extra  = fixed - (result << guard);
+
+			if (extra > 0 && extra + 2 < math::Unsigned(1) << guard) {
+				return result;
+			}
+		}
+	}
+
 	/**
 	 * @param digits
 	 * @return Pi to `digits` digits of precision
 	 */
 	static math::Rational pi(math::Unsigned digits) {
-		PiCalculator calc;
-		std::string  built = "3.";
+		std::uint64_t count;
+
+		if (!IntegerMath::to_word(digits, count)) {
+			throw std::overflow_error("Too many digits");
+		}
+
+		return math::Rational(
+			math::Integer(pi_digits(count)),
+			math::Integer(IntegerMath::pow(math::Unsigned(10), digits)));
+	}
+
+	/**
+	 * Binary splitting for 1/(a + 1)! + ... + 1/b!, times a!. The range is
+	 * split in two, and P(a, b) = P(a, m) Q(m, b) + P(m, b), with Q(a, b)
+	 * the product a + 1 through b, so Q(0, b) is b!. Big enough ranges
+	 * have their halves worked out on different threads.
+	 *
+	 * @param a The term before the first one
+	 * @param b The last term
+	 * @return P and Q for the range
+	 */
+	static Split euler(std::uint64_t a, std::uint64_t b) {
+		Split split;
+
+		if (b - a == 1) {
+			split.p = 1;
+			split.q = IntegerMath::from_word(b);
+
+			return split;
+		}
 
-		for (; digits > 0; digits--) {
-			built.append(calc.next_digit().to_string());
+		std::uint64_t mid = a + (b - a) / 2;
+		Split         lo, hi;
+
+		if (b - a < parallel_terms) {
+			lo = euler(a, mid);
+			hi = euler(mid, b);
+		} else {
+			Multiplication::run({
+				[&]() {
+					lo = euler(a, mid);
+				},
+				[&]() {
+					hi = euler(mid, b);
+				}
+			});
 		}
 
-		return built;
+		split.p = Multiplication::multiply(lo.p, hi.q) + hi.p;
+		split.q = Multiplication::multiply(lo.q, hi.q);
+
+		return split;
 	}
 
 	/**
-	 * https://stackoverflow.com/a/3028326
+	 * @return About how many digits n! has, by Stirling's approximation
+	 */
+	static double factorial_digits(std::uint64_t n) {
+		double x  = static_cast<double>(n);
+		double pi = std::acos(-1.0);
+
+		return (x * std::log(x) - x + std::log(2 * pi * x) / 2) /
+		       std::log(10.0);
+	}
+
+	/**
+	 * e * 10^digits, rounded half away from zero.
+	 *
+	 * The series is summed up to the first n with n! above 10^digits, the
+	 * same terms as it always has been, so the results don't change. That
+	 * n is guessed from Stirling's approximation, and checked against the
+	 * real n!, which comes out of the sum anyway.
 	 *
+	 * @param digits How many digits after the point
+	 * @return e's digits, up to and including the `digits`th one after the
+	 * point
+	 */
+	static math::Unsigned e_digits(size_t digits) {
+		math::Unsigned scale = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
+
+		std::uint64_t terms = 2;
+
+		while (factorial_digits(terms) <= digits) {
+			terms++;
+		}
+
+		Split sum;
+
+		while (true) {
+			sum = euler(0, terms);
+
+			/**
+			 * The guess is almost never off, but if it is, it's only by
+			 * one
+			 */
+			if (!(scale < sum.q)) {
+				terms++;
+			} else if (terms > 2 &&
+			           sum.q > IntegerMath::from_word(terms) * scale) {
+				terms--;
+			} else {
+				break;
+			}
+		}
+
+		/**
+		 * 1 + P / Q, rounded half away from zero, with a single division
+		 */
+		math::Unsigned quotient, remainder;
+
+		Division::divide(Multiplication::multiply(sum.q + sum.p, scale),
+		                 sum.q, quotient, remainder);
+
+		if (!(remainder * 2 < sum.q)) {
+			quotient += 1;
+		}
+
+		return quotient;
+	}
+
+	/**
+	 * e * 10^digits, rounded down. Unlike [[Irrational::e_digits]], this is
+	 * the real e rather than the sum of the first so many terms, which is
+	 * what [[IrrationalCache]] needs to round it again later.
+	 *
+	 * The series is summed until n! is above 10^digits times 2^guard, which
+	 * leaves the rest of it below one unit of the last guard bit. Like
+	 * [[Irrational::pi_digits]], the guard bits are dropped unless they're
+	 * right next to rolling over, in which case it's done again with more.
+	 *
+	 * @param digits How many digits after the point
+	 * @return e's digits, up to and including the `digits`th one after the
+	 * point
+	 */
+	static math::Unsigned e_floor(size_t digits) {
+		math::Unsigned decimal = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
+
+		for (size_t guard = 64;; guard *= 2) {
+			math::Unsigned scale = decimal << guard;
+
+			/**
+			 * A guard bit is about 0.30103 digits
+			 */
+			std::uint64_t terms = 2;
+
+			while (factorial_digits(terms) <=
+			       static_cast<double>(digits) + guard * 0.30103 + 1) {
+				terms++;
+			}
+
+			Split sum = euler(0, terms);
+
+			while (!(scale < sum.q)) {
+				sum = euler(0, ++terms);
+			}
+
+			/**
+			 * The terms left out and the division together are off by less
+			 * than 2
+			 */
+			math::Unsigned fixed, remainder;
+
+			Division::divide(Multiplication::multiply(sum.q + sum.p, scale),
+			                 sum.q, fixed, remainder);
+
+			math::Unsigned result = fixed >> guard;
+			math::Unsigned extra  = fixed - (result << guard);
+
+			if (extra + 2 < math::Unsigned(1) << guard) {
+				return result;
+			}
+		}
+	}
+
+	/**
 	 * @param digits
 	 * @return Euler's number to `digits` digits of precision
 	 */
 	static math::Rational e(size_t digits) {
-		math::Rational result = 2;
-		math::Unsigned fact   = 1;
-		math::Unsigned goal   = LD::ipow<math::Unsigned>(10, digits);
+		return math::Rational(
+			math::Integer(e_digits(digits)),
+			math::Integer(IntegerMath::pow(math::Unsigned(10),
+			                               IntegerMath::from_word(digits))));
+	}
 
-		for (math::Unsigned i = 2; fact <= goal; i++) {
-			fact *= i;
-			result += math::Rational(1, fact);
-		}
+	/**
+	 * Twice the golden ratio * 10^digits, rounded down.
+	 *
+	 * The golden ratio is (1 + sqrt(5)) / 2, so that's 10^digits +
+	 * floor(sqrt(5 * 10^(2 digits))). [[Irrational::isqrt]] finds that root
+	 * with precision doubling.
+	 */
+	static math::Unsigned golden_twice(size_t digits) {
+		math::Unsigned scale = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
 
-		return result.round(digits);
+		return scale + isqrt(IntegerMath::from_word(5) *
+		                     Multiplication::multiply(scale, scale));
 	}
 
 	/**
-	 * https://www.mathsisfun.com/numbers/golden-ratio.html
-	 * @ "The Most Irrational"
+	 * The golden ratio * 10^digits, rounded half away from zero.
 	 *
-	 * This algorithm is particularly inefficient, but I'm unable to find a
-	 * better one explained in plain English.
+	 * The ratio is irrational, so it's never exactly halfway between two
+	 * numbers, and halving [[Irrational::golden_twice]] rounds exactly the
+	 * same as the real thing would.
 	 *
+	 * @param digits How many digits after the point
+	 * @return The golden ratio's digits, up to and including the
+	 * `digits`th one after the point
+	 */
+	static math::Unsigned golden_digits(size_t digits) {
+		return (golden_twice(digits) + 1) >> 1;
+	}
+
+	/**
+	 * @param digits How many digits after the point
+	 * @return The golden ratio * 10^digits, rounded down
+	 */
+	static math::Unsigned golden_floor(size_t digits) {
+		return golden_twice(digits) >> 1;
+	}
+
+	/**
 	 * @param digits
 	 * @return The golden ratio to `digits` of precision
 	 */
 	static math::Rational golden_ratio(size_t digits) {
-		math::Rational result = 1,
-		               last   = 0,
-		               error  = math::Rational(1, LD::ipow<math::Unsigned>(
-			               10, digits));
+		return math::Rational(
+			math::Integer(golden_digits(digits)),
+			math::Integer(IntegerMath::pow(math::Unsigned(10),
+			                               IntegerMath::from_word(digits))));
+	}
 
-		while (LD::abs(result - last) > error) {
-			last   = result;
-			result = 1 + 1 / result;
+	/**
+	 * Finds the square root of `src` exactly, if it's the square of a
+	 * rational. In lowest terms, that's when the numerator and denominator
+	 * are both perfect squares.
+	 *
+	 * @param src The number
+	 * @param root Where to put the root, if there is one
+	 * @return Whether there was one
+	 */
+	static bool exact_sqrt(const math::Rational & src, math::Rational & root) {
+		if (src < 0) {
+			throw std::underflow_error("Can't find square root of negative"
+			                           " number");
 		}
 
-		return result.round(digits);
-		//return result - last;
+		math::Unsigned num      = src.numerator().abs();
+		math::Unsigned den      = src.denominator().abs();
+		math::Unsigned num_root = isqrt(num);
+
+		if (!(Multiplication::multiply(num_root, num_root) == num)) {
+			return false;
+		}
+
+		math::Unsigned den_root = isqrt(den);
+
+		if (!(Multiplication::multiply(den_root, den_root) == den)) {
+			return false;
+		}
+
+		root = math::Rational(math::Integer(num_root), math::Integer(den_root));
+
+		return true;
+	}
+
+	/**
+	 * Twice sqrt(src) * 10^digits, times q, rounded down, for `src` as p / q.
+	 *
+	 * sqrt(src) 10^digits is sqrt(p q) 10^digits / q, and twice the top of
+	 * that, rounded down, is the integer square root of
+	 * 4 p q 10^(2 digits), which [[Irrational::isqrt]] finds with precision
+	 * doubling.
+	 */
+	static math::Unsigned sqrt_twice(size_t digits,
+	                                 const math::Rational & src) {
+		math::Unsigned num   = src.numerator().abs();
+		math::Unsigned den   = src.denominator().abs();
+		math::Unsigned scale = IntegerMath::pow(
+			math::Unsigned(10), IntegerMath::from_word(digits));
+
+		return isqrt(
+			Multiplication::multiply(Multiplication::multiply(num, den) << 2,
+			                         Multiplication::multiply(scale, scale)));
 	}
 
 	/**
-	 * https://github.com/possibly-wrong/precision/issues/4#issuecomment-432800154
+	 * sqrt(src) * 10^digits, rounded half away from zero.
+	 *
+	 * Adding q to [[Irrational::sqrt_twice]] and dividing by 2 q rounds it
+	 * exactly the same as the real thing would.
 	 *
+	 * @param digits How many digits after the point
+	 * @param src The number, which can't be negative
+	 * @return The root's digits, up to and including the `digits`th one
+	 * after the point
+	 */
+	static math::Unsigned sqrt_digits(size_t digits,
+	                                  const math::Rational & src) {
+		math::Unsigned den = src.denominator().abs();
+		math::Unsigned quotient, remainder;
+
+		Division::divide(sqrt_twice(digits, src) + den, den << 1, quotient,
+		                 remainder);
+
+		return quotient;
+	}
+
+	/**
+	 * @param digits How many digits after the point
+	 * @param src The number, which can't be negative
+	 * @return sqrt(src) * 10^digits, rounded down
+	 */
+	static math::Unsigned sqrt_floor(size_t digits,
+	                                 const math::Rational & src) {
+		math::Unsigned den = src.denominator().abs();
+		math::Unsigned quotient, remainder;
+
+		Division::divide(sqrt_twice(digits, src), den << 1, quotient,
+		                 remainder);
+
+		return quotient;
+	}
+
+	/**
 	 * @param digits
 	 * @param src
-	 * @return sqrt(src) to `digits` of accuracy
+	 * @return sqrt(src) to `digits` of accuracy, or exactly if `src` is the
+	 * square of a rational
 	 */
 	static math::Rational sqrt(size_t digits, const math::Rational & src) {
-		if (src == 0) {
-			return 0;
-		} else if (src < 0) {
-			throw std::underflow_error("Can't find square root of negative"
-			                           " number");
-		}
+		math::Rational root;
 
-		math::Rational result = src,
-		               last,
-		               error  = math::Rational(1, LD::ipow<math::Unsigned>(
-			               10, digits));
-
-		while (LD::abs(result - last) > error) {
-			last   = result;
-			result = (result + src / result) / 2;
+		if (exact_sqrt(src, root)) {
+			return root;
 		}
 
-		return result.round(digits);
+		return math::Rational(
+			math::Integer(sqrt_digits(digits, src)),
+			math::Integer(IntegerMath::pow(math::Unsigned(10),
+			                               IntegerMath::from_word(digits))));
 	}
 
 	/**
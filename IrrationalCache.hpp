@@ -0,0 +1,338 @@
+#ifndef CALCULATOR_IRRATIONALCACHE_HPP
+#define CALCULATOR_IRRATIONALCACHE_HPP
+
+#include <string>
+#include <cstdint>
+
+#include "LRUCache.hpp"
+#include "Decimal.hpp"
+#include "Division.hpp"
+#include "IntegerMath.hpp"
+#include "Irrational.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * Remembers the digits of pi, e, the golden ratio and square roots, so asking
+ * for the same constant again, at the same precision or a lower one, doesn't
+ * start over.
+ *
+ * Only the most precise copy of each constant (and of each square root) is
+ * kept, as its digits rounded down, with [[IrrationalCache::guard_digits]]
+ * more than were asked for. Fewer digits are cut from those, and rounded
+ * using the digits after them. The constants are all irrational, so they're
+ * never exactly halfway, and rounding what's cached comes out the same as
+ * rounding the real thing. Squares of rationals have exact roots, which are
+ * never cached.
+ *
+ * Entries are thrown away least recently used first when they take up more
+ * than [[IrrationalCache::get_limit]] bytes. A limit of 0 turns the cache off.
+ */
+class IrrationalCache {
+	public:
+	enum Kind {
+		PI     = 0,
+		E      = 1,
+		GOLDEN = 2,
+		SQRT   = 3
+	};
+
+	/**
+	 * How many digits past the ones asked for are worked out and cached, so
+	 * asking for a few more later is still a hit
+	 */
+	static const size_t guard_digits = 16;
+
+	/**
+	 * How many values were cut from ones already cached
+	 */
+	unsigned long hits = 0;
+
+	/**
+	 * How many values had to be worked out from scratch
+	 */
+	unsigned long misses = 0;
+
+	private:
+	struct Entry {
+		/**
+		 * How many digits after the point
+		 */
+		size_t digits;
+
+		/**
+		 * The constant * 10^digits, rounded down
+		 */
+		math::Unsigned value;
+	};
+
+	/**
+	 * Keyed by [[IrrationalCache::key]]. The cost of every entry is roughly
+	 * its size in bytes.
+	 */
+	LRUCache<std::string, Entry> entries;
+
+	static std::string key(Kind kind, const math::Rational & argument) {
+		if (kind != SQRT) {
+			return std::to_string(kind);
+		}
+
+		return std::to_string(kind) + ":" +
+		       Decimal::to_string(argument.numerator()) + "/" +
+		       Decimal::to_string(argument.denominator());
+	}
+
+	/**
+	 * @return The constant * 10^digits, rounded down, from scratch
+	 */
+	static math::Unsigned compute(Kind kind, const math::Rational & argument,
+	                              size_t digits) {
+		switch (kind) {
+			case PI:
+				return Irrational::pi_digits(digits);
+			case E:
+				return Irrational::e_floor(digits);
+			case GOLDEN:
+				return Irrational::golden_floor(digits);
+			default:
+				return Irrational::sqrt_floor(digits, argument);
+		}
+	}
+
+	static math::Unsigned power(size_t digits) {
+		return IntegerMath::pow(math::Unsigned(10),
+		                        IntegerMath::from_word(digits));
+	}
+
+	/**
+	 * Finds the constant to at least `digits` digits, rounded down. If the
+	 * cached copy doesn't have that many, it's worked out again with
+	 * [[IrrationalCache::guard_digits]] more, and replaces it.
+	 *
+	 * @param kind Which constant
+	 * @param argument What it's the square root of, for [[SQRT]]
+	 * @param digits How many digits after the point are needed
+	 * @param found Where to put the constant's digits, rounded down
+	 * @return How many digits after the point `found` has
+	 */
+	size_t lookup(Kind kind, const math::Rational & argument, size_t digits,
+	              math::Unsigned & found) {
+		std::string k      = key(kind, argument);
+		Entry     * cached = entries.find(k);
+
+		if (cached != nullptr && cached->digits >= digits) {
+			hits++;
+
+			found = cached->value;
+
+			return cached->digits;
+		}
+
+		misses++;
+
+		Entry         entry {digits + guard_digits,
+		                     compute(kind, argument, digits + guard_digits)};
+		unsigned long cost = IntegerMath::bit_length(entry.value) / 8 + 1 +
+		                     k.size();
+
+		if (entries.fits(cost)) {
+			entries.insert(k, entry, cost);
+		}
+
+		found = entry.value;
+
+		return entry.digits;
+	}
+
+	/**
+	 * Rounds the constant to `digits` digits, half away from zero, from
+	 * [[IrrationalCache::lookup]]
+	 */
+	math::Unsigned rounded(Kind kind, const math::Rational & argument,
+	                       size_t digits) {
+		math::Unsigned found;
+		size_t         have = lookup(kind, argument, digits + 1, found);
+		math::Unsigned unit = power(have - digits);
+		math::Unsigned quotient, remainder;
+
+		Division::divide(found + (unit >> 1), unit, quotient, remainder);
+
+		return quotient;
+	}
+
+	/**
+	 * @return `num` / 10^digits
+	 */
+	static math::Rational fraction(const math::Unsigned & num, size_t digits) {
+		return math::Rational(math::Integer(num),
+		                      math::Integer(power(digits)));
+	}
+
+	public:
+	/**
+	 * @param limit The memory budget in bytes
+	 */
+	explicit IrrationalCache(unsigned long limit = 16 * 1024 * 1024)
+		: entries(limit) {}
+
+	/**
+	 * @return The same as [[Irrational::pi_digits]]
+	 */
+	math::Unsigned pi_digits(size_t digits) {
+		if (entries.get_limit() == 0) {
+			misses++;
+
+			return Irrational::pi_digits(digits);
+		}
+
+		math::Unsigned found, quotient, remainder;
+		size_t         have = lookup(PI, math::Rational(), digits, found);
+
+		Division::divide(found, power(have - digits), quotient, remainder);
+
+		return quotient;
+	}
+
+	/**
+	 * The same as [[Irrational::e_digits]], which sums a fixed number of
+	 * terms, n, and so falls short of e by less than 1/n of the last digit.
+	 * That only rounds differently from e itself if e's digits after the
+	 * last one are just past a half, and then it's worked out from scratch.
+	 */
+	math::Unsigned e_digits(size_t digits) {
+		if (entries.get_limit() == 0) {
+			misses++;
+
+			return Irrational::e_digits(digits);
+		}
+
+		math::Unsigned found;
+		size_t         have = lookup(E, math::Rational(), digits + 1, found);
+		math::Unsigned unit = power(have - digits);
+		math::Unsigned half = unit >> 1;
+		math::Unsigned quotient, remainder;
+
+		Division::divide(found, unit, quotient, remainder);
+
+		/**
+		 * Stirling's approximation is a little under n!, so this is at
+		 * most one past the real n
+		 */
+		std::uint64_t terms = 2;
+
+		while (Irrational::factorial_digits(terms) <= digits) {
+			terms++;
+		}
+
+		math::Unsigned low = IntegerMath::from_word(
+			terms > 3 ? terms - 1 : 2);
+
+		if (remainder < half) {
+			return quotient;
+		} else if (!(remainder * low < half * low + unit)) {
+			return quotient + 1;
+		}
+
+		return Irrational::e_digits(digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::golden_digits]]
+	 */
+	math::Unsigned golden_digits(size_t digits) {
+		if (entries.get_limit() == 0) {
+			misses++;
+
+			return Irrational::golden_digits(digits);
+		}
+
+		return rounded(GOLDEN, math::Rational(), digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::sqrt_digits]], for a `src` that
+	 * isn't the square of a rational
+	 */
+	math::Unsigned sqrt_digits(size_t digits, const math::Rational & src) {
+		if (entries.get_limit() == 0) {
+			misses++;
+
+			return Irrational::sqrt_digits(digits, src);
+		}
+
+		return rounded(SQRT, src, digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::pi]]
+	 */
+	math::Rational pi(size_t digits) {
+		return fraction(pi_digits(digits), digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::e]]
+	 */
+	math::Rational e(size_t digits) {
+		return fraction(e_digits(digits), digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::golden_ratio]]
+	 */
+	math::Rational golden_ratio(size_t digits) {
+		return fraction(golden_digits(digits), digits);
+	}
+
+	/**
+	 * @return The same as [[Irrational::sqrt]]
+	 */
+	math::Rational sqrt(size_t digits, const math::Rational & src) {
+		math::Rational root;
+
+		if (Irrational::exact_sqrt(src, root)) {
+			return root;
+		}
+
+		return fraction(sqrt_digits(digits, src), digits);
+	}
+
+	/**
+	 * Sets the memory budget in bytes, evicting entries if the cache is now
+	 * over it. 0 turns the cache off.
+	 */
+	void set_limit(unsigned long limit) {
+		entries.set_limit(limit);
+	}
+
+	/**
+	 * @return The memory budget in bytes
+	 */
+	unsigned long get_limit() const {
+		return entries.get_limit();
+	}
+
+	/**
+	 * @return Roughly how many bytes are in use
+	 */
+	unsigned long get_used() const {
+		return entries.get_used();
+	}
+
+	/**
+	 * @return How many constants are cached
+	 */
+	unsigned long size() const {
+		return entries.size();
+	}
+
+	/**
+	 * Forgets every constant. The hit and miss counters are kept.
+	 */
+	void clear() {
+		entries.clear();
+	}
+};
+
+#endif //CALCULATOR_IRRATIONALCACHE_HPP
@@ -0,0 +1,217 @@
+#ifndef CALCULATOR_LRUCACHE_HPP
+#define CALCULATOR_LRUCACHE_HPP
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * A bounded cache that throws away whatever was used least recently once it's
+ * full.
+ *
+ * Every entry has a cost, and the total cost of all entries is kept under
+ * [[LRUCache::get_limit]]. By default every entry costs 1, so the limit is just
+ * the number of entries, but caches of things that vary wildly in size can use
+ * something like the number of bytes instead.
+ *
+ * @tparam Key The key type. Must work with [[std::hash]].
+ * @tparam Value The value type.
+ */
+template <class Key, class Value>
+	class LRUCache {
+		struct Entry {
+			Key           key;
+			Value         value;
+			unsigned long cost;
+		};
+
+		/**
+		 * Most recently used first
+		 */
+		std::list<Entry> entries;
+
+		std::unordered_map<Key, typename std::list<Entry>::iterator> lookup;
+
+		unsigned long limit;
+		unsigned long used = 0;
+
+		/**
+		 * Throws away the least recently used entries until everything fits,
+		 * but never the most recently used one.
+		 */
+		void evict() {
+			while (used > limit && entries.size() > 1) {
+				used -= entries.back().cost;
+				lookup.erase(entries.back().key);
+				entries.pop_back();
+			}
+		}
+
+		/**
+		 * Rebuilds [[LRUCache::lookup]] from [[LRUCache::entries]].
+		 */
+		void reindex() {
+			lookup.clear();
+
+			for (auto it = entries.begin(); it != entries.end(); ++it) {
+				lookup[it->key] = it;
+			}
+		}
+
+		public:
+		/**
+		 * How many times [[LRUCache::find]] found something
+		 */
+		unsigned long hits = 0;
+
+		/**
+		 * How many times [[LRUCache::find]] didn't find anything
+		 */
+		unsigned long misses = 0;
+
+		explicit LRUCache(unsigned long limit) : limit(limit) {}
+
+		/**
+		 * [[LRUCache::lookup]] points into [[LRUCache::entries]], so copies
+		 * need their own lookup table pointing into their own entries.
+		 */
+		LRUCache(const LRUCache & other)
+			: entries(other.entries), limit(other.limit), used(other.used),
+			  hits(other.hits), misses(other.misses) {
+			reindex();
+		}
+
+		LRUCache & operator=(const LRUCache & other) {
+			if (this != & other) {
+				entries = other.entries;
+				limit   = other.limit;
+				used    = other.used;
+				hits    = other.hits;
+				misses  = other.misses;
+
+				reindex();
+			}
+
+			return * this;
+		}
+
+		LRUCache(LRUCache && other) noexcept = default;
+		LRUCache & operator=(LRUCache && other) noexcept = default;
+
+		/**
+		 * Looks up `key`, marking it as the most recently used entry.
+		 *
+		 * @param key The key to look up
+		 * @return The value, or `nullptr` if it isn't cached. The pointer is
+		 * valid until the entry is evicted.
+		 */
+		Value * find(const Key & key) {
+			auto found = lookup.find(key);
+
+			if (found == lookup.end()) {
+				misses++;
+
+				return nullptr;
+			}
+
+			hits++;
+
+			/**
+			 * Move it to the front without invalidating any iterators
+			 */
+			entries.splice(entries.begin(), entries, found->second);
+
+			return & found->second->value;
+		}
+
+		/**
+		 * Whether `key` is cached. Unlike [[LRUCache::find]], this doesn't
+		 * count as a hit or miss, or as using the entry.
+		 */
+		bool contains(const Key & key) const {
+			return lookup.count(key) > 0;
+		}
+
+		/**
+		 * Whether an entry with cost `cost` can be cached at all.
+		 */
+		bool fits(unsigned long cost = 1) const {
+			return cost <= limit;
+		}
+
+		/**
+		 * Caches `value` under `key`, replacing any entry that's already
+		 * there, and evicts older entries to make room for it.
+		 *
+		 * The new entry itself is always kept until the next insertion, even
+		 * if it doesn't fit. Use [[LRUCache::fits]] first if that matters.
+		 *
+		 * @return The cached value
+		 */
+		Value & insert(const Key & key, Value value, unsigned long cost = 1) {
+			erase(key);
+
+			entries.push_front(Entry {key, std::move(value), cost});
+			lookup[key] = entries.begin();
+			used += cost;
+
+			evict();
+
+			return entries.front().value;
+		}
+
+		/**
+		 * Removes `key` from the cache, if it's there.
+		 */
+		void erase(const Key & key) {
+			auto found = lookup.find(key);
+
+			if (found != lookup.end()) {
+				used -= found->second->cost;
+				entries.erase(found->second);
+				lookup.erase(found);
+			}
+		}
+
+		/**
+		 * Removes everything. The hit and miss counters are kept.
+		 */
+		void clear() {
+			entries.clear();
+			lookup.clear();
+			used = 0;
+		}
+
+		/**
+		 * Sets the limit, evicting entries if the cache is now over it.
+		 */
+		void set_limit(unsigned long new_limit) {
+			limit = new_limit;
+
+			if (limit == 0) {
+				clear();
+			} else {
+				evict();
+			}
+		}
+
+		unsigned long get_limit() const {
+			return limit;
+		}
+
+		/**
+		 * @return The total cost of all entries
+		 */
+		unsigned long get_used() const {
+			return used;
+		}
+
+		/**
+		 * @return The number of entries
+		 */
+		unsigned long size() const {
+			return entries.size();
+		}
+	};
+
+#endif //CALCULATOR_LRUCACHE_HPP
@@ -0,0 +1,691 @@
+#ifndef CALCULATOR_MULTIPLICATION_HPP
+#define CALCULATOR_MULTIPLICATION_HPP
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <utility>
+#include <functional>
+
+#include "ThreadPool.hpp"
+
+#include "boilerplate/ld_boilerplate.hpp"
+#include "boilerplate/precision/math_Rational.h"
+
+/**
+ * Multiplication of big integers, picking an algorithm by how big they are.
+ *
+ * Sizes are counted in 32-bit limbs. Below
+ * [[Multiplication::karatsuba_threshold]] limbs the library's own
+ * multiplication (schoolbook) is the fastest there is. Above that, numbers
+ * are split into pieces and multiplied with Karatsuba (3 products of half the
+ * size), then Toom-3 (5 products of a third of the size), and the largest
+ * ones are multiplied as a convolution with number theoretic transforms,
+ * which takes O(n log n) instead of a power of n.
+ *
+ * Sub-products of numbers above [[Multiplication::parallel_threshold]] limbs
+ * are spread across a [[ThreadPool]] of [[Multiplication::get_threads]]
+ * threads. The result is the same no matter how many threads there are.
+ */
+struct Multiplication {
+	/**
+	 * Below this many limbs, the library multiplies
+	 */
+	static const size_t karatsuba_threshold = 300;
+
+	/**
+	 * Below this many limbs, Karatsuba is used instead of Toom-3
+	 */
+	static const size_t toom3_threshold = 800;
+
+	/**
+	 * Below this many limbs, Toom-3 is used instead of transforms
+	 */
+	static const size_t ntt_threshold = 2500;
+
+	/**
+	 * Below this many limbs, sub-products are worked out one at a time
+	 */
+	static const size_t parallel_threshold = 1000;
+
+	private:
+	static const unsigned limb_bits = 32;
+
+	/**
+	 * The primes the transforms are done modulo, with a primitive root of
+	 * each. The multiplicative group of both has 2^23 dividing its order,
+	 * so transforms can be up to 2^23 long. Convolutions are worked out
+	 * modulo both and then put back together with the CRT, so the primes'
+	 * product (about 2^58.7) has to be larger than any coefficient.
+	 */
+	static const std::uint32_t prime1 = 998244353;
+	static const std::uint32_t root1  = 3;
+	static const std::uint32_t prime2 = 469762049;
+	static const std::uint32_t root2  = 3;
+
+	/**
+	 * The longest transform there can be
+	 */
+	static const size_t ntt_length = size_t(1) << 23;
+
+	static unsigned & threads() {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+		/**
+		 * The web build has no threads to start
+		 */
+		static unsigned count = 1;
+#else
+		static unsigned count = std::thread::hardware_concurrency() > 0
+		                        ? std::thread::hardware_concurrency() : 1;
+#endif
+
+		return count;
+	}
+
+	static std::unique_ptr<ThreadPool> & pool_instance() {
+		static std::unique_ptr<ThreadPool> instance;
+
+		return instance;
+	}
+
+	/**
+	 * @return The shared pool, started the first time it's needed
+	 */
+	static ThreadPool & pool() {
+		std::unique_ptr<ThreadPool> & instance = pool_instance();
+
+		if (!instance) {
+			instance.reset(new ThreadPool(threads()));
+		}
+
+		return * instance;
+	}
+
+	/**
+	 * Runs `jobs` in parallel if `limbs` is big enough for that to be worth
+	 * it, and one by one if not.
+	 */
+	static void run(const std::vector<std::function<void()>> & jobs,
+	                size_t limbs) {
+		if (limbs >= parallel_threshold) {
+			run(jobs);
+		} else {
+			for (const std::function<void()> & job : jobs) {
+				job();
+			}
+		}
+	}
+
+	/**
+	 * @return 2 to the power of `limbs` limbs, the first number that's
+	 * `limbs + 1` limbs long
+	 */
+	static math::Unsigned limb_power(size_t limbs) {
+		return math::Unsigned(1) << (limb_bits * limbs);
+	}
+
+	/**
+	 * @return How many limbs `num` takes up, at least 1
+	 */
+	static size_t limbs(const math::Unsigned & num) {
+		/**
+		 * Double until everything's shifted out, then binary search
+		 */
+		size_t hi = 1;
+
+		while ((num >> (limb_bits * hi)) > 0) {
+			hi *= 2;
+		}
+
+		size_t lo = hi / 2;
+
+		while (hi - lo > 1) {
+			size_t mid = lo + (hi - lo) / 2;
+
+			if ((num >> (limb_bits * mid)) > 0) {
+				lo = mid;
+			} else {
+				hi = mid;
+			}
+		}
+
+		return hi;
+	}
+
+	/**
+	 * Splits `num` into the limbs above and below `limbs`
+	 */
+	static void split(const math::Unsigned & num, size_t limbs,
+	                  math::Unsigned & hi, math::Unsigned & lo) {
+		hi = num >> (limb_bits * limbs);
+		lo = num - (hi << (limb_bits * limbs));
+	}
+
+	/**
+	 * Writes the lowest `count` limbs of `num` to `out`, starting at
+	 * `offset`. Halving the number each time means every level of the
+	 * recursion only copies it once.
+	 */
+	static void to_limbs(const math::Unsigned & num, size_t count,
+	                     std::vector<std::uint32_t> & out, size_t offset) {
+		if (count == 1) {
+			out[offset] = num.to_uint();
+
+			return;
+		}
+
+		size_t         half = count / 2;
+		math::Unsigned hi, lo;
+
+		split(num, half, hi, lo);
+
+		to_limbs(lo, half, out, offset);
+		to_limbs(hi, count - half, out, offset + half);
+	}
+
+	/**
+	 * @return The number made of `limbs[begin]` through `limbs[end - 1]`,
+	 * least significant first
+	 */
+	static math::Unsigned from_limbs(const std::vector<std::uint32_t> & limbs,
+	                                 size_t begin, size_t end) {
+		if (end - begin == 1) {
+			return math::Unsigned(
+				static_cast<math::Unsigned::Digit>(limbs[begin]));
+		}
+
+		size_t mid = begin + (end - begin) / 2;
+
+		return (from_limbs(limbs, mid, end) << (limb_bits * (mid - begin))) +
+		       from_limbs(limbs, begin, mid);
+	}
+
+	template <std::uint32_t Mod>
+		static std::uint32_t pow_mod(std::uint64_t base, std::uint64_t exp) {
+			std::uint64_t result = 1;
+
+			base %= Mod;
+
+			while (exp > 0) {
+				if (exp & 1) {
+					result = result * base % Mod;
+				}
+
+				base = base * base % Mod;
+				exp >>= 1;
+			}
+
+			return static_cast<std::uint32_t>(result);
+		}
+
+	/**
+	 * Number theoretic transform of `values` in place, modulo `Mod`. Their
+	 * count must be a power of 2. The inverse transform includes dividing
+	 * by the count.
+	 */
+	template <std::uint32_t Mod, std::uint32_t Root>
+		static void transform(std::vector<std::uint32_t> & values,
+		                      bool inverse) {
+			size_t n = values.size();
+
+			/**
+			 * Bit reversal permutation
+			 */
+			for (size_t i = 1, j = 0; i < n; i++) {
+				size_t bit = n >> 1;
+
+				for (; j & bit; bit >>= 1) {
+					j ^= bit;
+				}
+
+				j ^= bit;
+
+				if (i < j) {
+					std::swap(values[i], values[j]);
+				}
+			}
+
+			std::vector<std::uint32_t> twiddles(n / 2);
+
+			for (size_t len = 2; len <= n; len <<= 1) {
+				std::uint64_t step = pow_mod<Mod>(Root, (Mod - 1) / len);
+
+				if (inverse) {
+					step = pow_mod<Mod>(step, Mod - 2);
+				}
+
+				size_t half = len / 2;
+
+				twiddles[0] = 1;
+
+				for (size_t k = 1; k < half; k++) {
+					twiddles[k] = static_cast<std::uint32_t>(
+						twiddles[k - 1] * step % Mod);
+				}
+
+				for (size_t i = 0; i < n; i += len) {
+					for (size_t k = 0; k < half; k++) {
+						std::uint32_t u = values[i + k];
+						std::uint32_t v = static_cast<std::uint32_t>(
+							std::uint64_t(values[i + k + half]) * twiddles[k] %
+							Mod);
+
+						values[i + k]        = u + v >= Mod ? u + v - Mod
+						                                    : u + v;
+						values[i + k + half] = u >= v ? u - v : u + Mod - v;
+					}
+				}
+			}
+
+			if (inverse) {
+				std::uint64_t scale = pow_mod<Mod>(n, Mod - 2);
+
+				for (std::uint32_t & value : values) {
+					value = static_cast<std::uint32_t>(value * scale % Mod);
+				}
+			}
+		}
+
+	/**
+	 * Transforms `digits` modulo `Mod`, multiplies it pointwise by the
+	 * transform of `other` (or by itself, if `other` is null), and
+	 * transforms it back, leaving the cyclic convolution in `digits`.
+	 */
+	template <std::uint32_t Mod, std::uint32_t Root>
+		static void convolve(std::vector<std::uint32_t> & digits,
+		                     std::vector<std::uint32_t> * other,
+		                     size_t limbs) {
+			std::vector<std::function<void()>> jobs {
+				[&]() {
+					transform<Mod, Root>(digits, false);
+				}
+			};
+
+			if (other) {
+				jobs.push_back([&]() {
+					transform<Mod, Root>(* other, false);
+				});
+			}
+
+			run(jobs, limbs);
+
+			for (size_t i = 0; i < digits.size(); i++) {
+				std::uint64_t rhs = other ? (* other)[i] : digits[i];
+
+				digits[i] = static_cast<std::uint32_t>(digits[i] * rhs % Mod);
+			}
+
+			transform<Mod, Root>(digits, true);
+		}
+
+	/**
+	 * @return The limbs of `num` split into 16-bit digits, in a vector of
+	 * `length` values
+	 */
+	static std::vector<std::uint32_t> to_digits(const math::Unsigned & num,
+	                                            size_t limbs, size_t length) {
+		std::vector<std::uint32_t> limb_values(limbs);
+		std::vector<std::uint32_t> digits(length);
+
+		to_limbs(num, limbs, limb_values, 0);
+
+		for (size_t i = 0; i < limbs; i++) {
+			digits[2 * i]     = limb_values[i] & 0xFFFF;
+			digits[2 * i + 1] = limb_values[i] >> 16;
+		}
+
+		return digits;
+	}
+
+	/**
+	 * Multiplies by convolving the numbers' 16-bit digits. Digits that
+	 * small keep every coefficient of the convolution below 2^54 for any
+	 * transform that fits in [[Multiplication::ntt_length]].
+	 */
+	static math::Unsigned multiply_ntt(const math::Unsigned & a, size_t la,
+	                                   const math::Unsigned & b, size_t lb,
+	                                   bool square) {
+		size_t length = 1;
+
+		while (length < 2 * (la + lb)) {
+			length <<= 1;
+		}
+
+		std::vector<std::uint32_t> a1, a2, b1, b2;
+
+		std::vector<std::function<void()>> jobs {
+			[&]() {
+				a1 = to_digits(a, la, length);
+			}
+		};
+
+		if (!square) {
+			jobs.push_back([&]() {
+				b1 = to_digits(b, lb, length);
+			});
+		}
+
+		run(jobs, la);
+
+		a2 = a1;
+		b2 = b1;
+
+		run({
+			[&]() {
+				convolve<prime1, root1>(a1, square ? nullptr : & b1, la);
+			},
+			[&]() {
+				convolve<prime2, root2>(a2, square ? nullptr : & b2, la);
+			}
+		}, la);
+
+		/**
+		 * Put every coefficient back together from its two residues with
+		 * the CRT, and carry into 32-bit limbs
+		 */
+		std::uint64_t inverse = pow_mod<prime2>(prime1, prime2 - 2);
+		std::uint64_t carry   = 0;
+
+		std::vector<std::uint32_t> limb_values(la + lb);
+
+		for (size_t i = 0; i < 2 * (la + lb); i++) {
+			std::uint64_t r1 = a1[i], r2 = a2[i];
+			std::uint64_t k  = (r2 + prime2 - r1 % prime2) % prime2 * inverse %
+			                   prime2;
+
+			carry += r1 + k * prime1;
+
+			if (i % 2) {
+				limb_values[i / 2] |= static_cast<std::uint32_t>(
+					(carry & 0xFFFF) << 16);
+			} else {
+				limb_values[i / 2] = static_cast<std::uint32_t>(
+					carry & 0xFFFF);
+			}
+
+			carry >>= 16;
+		}
+
+		return from_limbs(limb_values, 0, limb_values.size());
+	}
+
+	/**
+	 * Karatsuba: with each number split in half at B, (a1 B + a0)(b1 B +
+	 * b0) is a1 b1 B^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B + a0 b0,
+	 * which is 3 half-size products instead of 4.
+	 */
+	static math::Unsigned multiply_karatsuba(const math::Unsigned & a,
+	                                         const math::Unsigned & b,
+	                                         size_t limbs) {
+		size_t         k = (limbs + 1) / 2;
+		math::Unsigned a1, a0, b1, b0;
+
+		split(a, k, a1, a0);
+		split(b, k, b1, b0);
+
+		math::Unsigned z0, z1, z2;
+
+		run({
+			[&]() {
+				z0 = multiply(a0, k, b0, k);
+			},
+			[&]() {
+				z1 = multiply(a0 + a1, k + 1, b0 + b1, k + 1);
+			},
+			[&]() {
+				z2 = multiply(a1, limbs - k, b1, limbs - k);
+			}
+		}, limbs);
+
+		z1 -= z0;
+		z1 -= z2;
+
+		return (z2 << (2 * limb_bits * k)) + (z1 << (limb_bits * k)) + z0;
+	}
+
+	/**
+	 * @return `a` times `b`, which may be negative
+	 */
+	static math::Integer multiply_signed(const math::Integer & a,
+	                                     const math::Integer & b,
+	                                     size_t limbs) {
+		math::Integer result(multiply(a.abs(), limbs, b.abs(), limbs));
+
+		return (a < 0) != (b < 0) ? -result : result;
+	}
+
+	/**
+	 * Toom-3: each number is split into thirds, making it a polynomial of
+	 * degree 2 in B. The product is a polynomial of degree 4, which is
+	 * found from its value at 0, 1, -1, -2 and infinity (5 products of a
+	 * third of the size). This is Bodrato's sequence for evaluating and
+	 * interpolating.
+	 */
+	static math::Unsigned multiply_toom3(const math::Unsigned & a,
+	                                     const math::Unsigned & b,
+	                                     size_t limbs) {
+		size_t         k = (limbs + 2) / 3;
+		math::Unsigned a2, a1, a0, b2, b1, b0, rest;
+
+		split(a, 2 * k, a2, rest);
+		split(rest, k, a1, a0);
+		split(b, 2 * k, b2, rest);
+		split(rest, k, b1, b0);
+
+		/**
+		 * p(1), p(-1) and p(-2) for both numbers
+		 */
+		math::Integer pa = math::Integer(a0) + math::Integer(a2);
+		math::Integer pb = math::Integer(b0) + math::Integer(b2);
+		math::Integer ma1 = pa - math::Integer(a1);
+		math::Integer mb1 = pb - math::Integer(b1);
+		math::Integer ma2 = (ma1 + math::Integer(a2)) * 2 - math::Integer(a0);
+		math::Integer mb2 = (mb1 + math::Integer(b2)) * 2 - math::Integer(b0);
+
+		pa += math::Integer(a1);
+		pb += math::Integer(b1);
+
+		math::Unsigned r0, rinf;
+		math::Integer  r1, rm1, rm2;
+
+		run({
+			[&]() {
+				r0 = multiply(a0, k, b0, k);
+			},
+			[&]() {
+				r1 = multiply_signed(pa, pb, k + 1);
+			},
+			[&]() {
+				rm1 = multiply_signed(ma1, mb1, k + 1);
+			},
+			[&]() {
+				rm2 = multiply_signed(ma2, mb2, k + 2);
+			},
+			[&]() {
+				rinf = multiply(a2, limbs - 2 * k, b2, limbs - 2 * k);
+			}
+		}, limbs);
+
+		math::Integer c0(r0), c4(rinf);
+		math::Integer c3 = (rm2 - r1) / 3;
+		math::Integer c1 = (r1 - rm1) / 2;
+		math::Integer c2 = rm1 - c0;
+
+		c3 = (c2 - c3) / 2 + c4 * 2;
+		c2 = c2 + c1 - c4;
+		c1 = c1 - c3;
+
+		/**
+		 * Every coefficient of the product is a sum of products of pieces,
+		 * so none of them are negative
+		 */
+		return (rinf << (4 * limb_bits * k)) +
+		       (c3.abs() << (3 * limb_bits * k)) +
+		       (c2.abs() << (2 * limb_bits * k)) +
+		       (c1.abs() << (limb_bits * k)) + r0;
+	}
+
+	/**
+	 * Multiplies two numbers that are at most `la` and `lb` limbs long.
+	 */
+	static math::Unsigned multiply(const math::Unsigned & a, size_t la,
+	                               const math::Unsigned & b, size_t lb) {
+		if (la < lb) {
+			return multiply(b, lb, a, la);
+		} else if (lb < karatsuba_threshold) {
+			return a * b;
+		} else if (lb >= ntt_threshold && 2 * (la + lb) <= ntt_length) {
+			/**
+			 * Transforms take as long as the total size, however lopsided
+			 */
+			return multiply_ntt(a, la, b, lb, false);
+		} else if (la > 2 * lb) {
+			/**
+			 * Lopsided, so split the longer one until the pieces are about
+			 * the size of the shorter one, and multiply those separately
+			 */
+			size_t         k = la / 2;
+			math::Unsigned hi, lo, hi_product, lo_product;
+
+			split(a, k, hi, lo);
+
+			run({
+				[&]() {
+					lo_product = multiply(lo, k, b, lb);
+				},
+				[&]() {
+					hi_product = multiply(hi, la - k, b, lb);
+				}
+			}, lb);
+
+			return (hi_product << (limb_bits * k)) + lo_product;
+		} else if (lb >= toom3_threshold) {
+			return multiply_toom3(a, b, la);
+		}
+
+		return multiply_karatsuba(a, b, la);
+	}
+
+	public:
+	/**
+	 * @return `a` times `b`
+	 */
+	static math::Unsigned multiply(const math::Unsigned & a,
+	                               const math::Unsigned & b) {
+		static const math::Unsigned small = limb_power(karatsuba_threshold);
+
+		if (a < small || b < small) {
+			return a * b;
+		}
+
+		size_t la = limbs(a);
+
+		/**
+		 * Squaring only needs one transform per prime instead of two
+		 */
+		if (& a == & b && la >= ntt_threshold && 4 * la <= ntt_length) {
+			return multiply_ntt(a, la, a, la, true);
+		}
+
+		return multiply(a, la, b, & a == & b ? la : limbs(b));
+	}
+
+	/**
+	 * @return `a` times `b`
+	 */
+	static math::Integer multiply(const math::Integer & a,
+	                              const math::Integer & b) {
+		math::Unsigned magnitude = a.abs();
+		math::Integer  result(& a == & b ? multiply(magnitude, magnitude)
+		                                 : multiply(magnitude, b.abs()));
+
+		return (a < 0) != (b < 0) ? -result : result;
+	}
+
+	/**
+	 * @return `a` times `b`, in lowest terms
+	 */
+	static math::Rational multiply(const math::Rational & a,
+	                               const math::Rational & b) {
+		static const math::Integer small(limb_power(karatsuba_threshold));
+
+		math::Integer an = a.numerator(), ad = a.denominator();
+		math::Integer bn = b.numerator(), bd = b.denominator();
+
+		if ((an < small && -small < an && ad < small) ||
+		    (bn < small && -small < bn && bd < small)) {
+			return a * b;
+		}
+
+		return math::Rational(multiply(an, bn), multiply(ad, bd));
+	}
+
+	/**
+	 * @return `a` divided by `b`, in lowest terms. `b` can't be 0.
+	 */
+	static math::Rational divide(const math::Rational & a,
+	                             const math::Rational & b) {
+		static const math::Integer small(limb_power(karatsuba_threshold));
+
+		math::Integer an = a.numerator(), ad = a.denominator();
+		math::Integer bn = b.numerator(), bd = b.denominator();
+
+		if (bn == 0 || (an < small && -small < an && ad < small) ||
+		    (bn < small && -small < bn && bd < small)) {
+			return a / b;
+		}
+
+		math::Integer num = multiply(an, bd);
+		math::Integer den = multiply(ad, bn);
+
+		return den < 0 ? math::Rational(-num, -den) : math::Rational(num, den);
+	}
+
+	/**
+	 * Anything else is multiplied the normal way
+	 */
+	template <class Num>
+		static Num multiply(const Num & a, const Num & b) {
+			return a * b;
+		}
+
+	template <class Num>
+		static Num divide(const Num & a, const Num & b) {
+			return a / b;
+		}
+
+	/**
+	 * Runs `jobs` on the same pool multiplications use, and returns once
+	 * all of them are done. With only 1 thread, they're run one by one.
+	 */
+	static void run(const std::vector<std::function<void()>> & jobs) {
+		if (threads() > 1) {
+			pool().run(jobs);
+		} else {
+			for (const std::function<void()> & job : jobs) {
+				job();
+			}
+		}
+	}
+
+	/**
+	 * @return How many threads multiplications are spread across
+	 */
+	static unsigned get_threads() {
+		return threads();
+	}
+
+	/**
+	 * Sets how many threads multiplications are spread across. The pool is
+	 * restarted the next time it's needed.
+	 *
+	 * @param count At least 1
+	 */
+	static void set_threads(unsigned count) {
+		threads() = count > 0 ? count : 1;
+		pool_instance().reset();
+	}
+};
+
+#endif //CALCULATOR_MULTIPLICATION_HPP
@@ -9,12 +9,17 @@
 #include "Calculator.cpp"
 #include "boilerplate/precision/math_Rational.h"
 #include "Irrational.hpp"
+#include "Decimal.hpp"
+#include "Multiplication.hpp"
 
-bool RationalCalculator::is_int(const math::Rational & num) {
+template <class Num>
+bool BasicRationalCalculator<Num>::is_int(const Num & num) {
 	return num.denominator().abs() == 1;
 }
 
-std::wstring RationalCalculator::commatize_str(const std::wstring & str) {
+template <class Num>
+std::wstring BasicRationalCalculator<Num>::commatize_str(
+	const std::wstring & str) {
 	if (str.length() <= 3) {
 		return str;
 	}
@@ -29,22 +34,78 @@ std::wstring RationalCalculator::commatize_str(const std::wstring & str) {
 	return built.substr(static_cast<unsigned long>(rem == 0));
 }
 
-std::wstring RationalCalculator::to_string(const math::Rational & num) {
+template <class Num>
+std::wstring BasicRationalCalculator<Num>::factorial_cache_stats() {
+	unsigned long lookups = factorial_cache.hits + factorial_cache.misses;
+
+	std::wstring built =
+		             L"Factorials: " +
+		             LD::wtostring(factorial_cache.size()) + L" cached, " +
+		             LD::wtostring(factorial_cache.get_used()) + L"/" +
+		             LD::wtostring(factorial_cache.get_limit()) +
+		             L" bytes, " +
+		             LD::wtostring(factorial_cache.hits) + L" hits, " +
+		             LD::wtostring(factorial_cache.misses) + L" misses";
+
+	if (lookups > 0) {
+		built.append(L" (" + LD::wtostring(
+			factorial_cache.hits * 100 / lookups) + L"% hit rate)");
+	}
+
+	return built;
+}
+
+template <class Num>
+std::wstring BasicRationalCalculator<Num>::irrational_cache_stats() {
+	unsigned long lookups = irrational_cache.hits +
+	                        irrational_cache.misses;
+
+	std::wstring built =
+		             L"Irrationals: " +
+		             LD::wtostring(irrational_cache.size()) + L" cached, " +
+		             LD::wtostring(irrational_cache.get_used()) + L"/" +
+		             LD::wtostring(irrational_cache.get_limit()) +
+		             L" bytes, " +
+		             LD::wtostring(irrational_cache.hits) + L" hits, " +
+		             LD::wtostring(irrational_cache.misses) + L" misses";
+
+	if (lookups > 0) {
+		built.append(L" (" + LD::wtostring(
+			irrational_cache.hits * 100 / lookups) + L"% hit rate)");
+	}
+
+	return built;
+}
+
+template <class Num>
+std::wstring BasicRationalCalculator<Num>::to_string(const Num & num) {
 	if (precision == -2) {
 		if (num.denominator() == 1) {
-			return commatize_str(LD::s2wstr(num.to_string()));
+			return commatize_str(
+				LD::s2wstr(Decimal::to_string(num.numerator())));
 		}
 
-		return commatize_str(LD::s2wstr(num.numerator().to_string())) + L"/" +
-		       commatize_str(LD::s2wstr(num.denominator().to_string()));
+		return commatize_str(
+			       LD::s2wstr(Decimal::to_string(num.numerator()))) +
+		       L"/" +
+		       commatize_str(
+			       LD::s2wstr(Decimal::to_string(num.denominator())));
 	}
 
 	std::wstring decimal;
 
-	if (precision < 0) {
+	if (precision < 0 && num.denominator() == 1) {
+		/**
+		 * Integers have no repeating part to look for, so they can skip
+		 * the long division
+		 */
+		decimal = LD::s2wstr(Decimal::to_string(num.numerator()));
+	} else if (precision < 0) {
 		decimal = LD::s2wstr(num.to_precise_string());
 	} else {
-		decimal = LD::s2wstr(num.to_string(static_cast<size_t>(precision)));
+		decimal = LD::s2wstr(Decimal::to_string(
+			num.numerator(), num.denominator(),
+			static_cast<size_t>(precision)));
 	}
 
 	if (commatize) {
@@ -74,14 +135,16 @@ std::wstring RationalCalculator::to_string(const math::Rational & num) {
 	return decimal;
 }
 
-RationalCalculator::RationalCalculator() : Calculator<math::Rational>() {
+template <class Num>
+BasicRationalCalculator<Num>::BasicRationalCalculator() : Calculator<Num>() {
 	register_commands();
 	generate_commands_help();
 	register_functions();
 	generate_functions_help();
 }
 
-void RationalCalculator::register_commands() {
+template <class Num>
+void BasicRationalCalculator<Num>::register_commands() {
 	/**
 	 * document function added manually in main.cpp
 	 */
@@ -141,6 +204,12 @@ void RationalCalculator::register_commands() {
 							                       L"Can't convert to integer");
 						}
 					}
+
+					/**
+					 * sqrt() depends on the precision, and it's folded
+					 * ahead of time, so old results can't be reused
+					 */
+					invalidate_cache();
 				}
 
 				return L"Precision set!";
@@ -247,9 +316,9 @@ void RationalCalculator::register_commands() {
 			/**
 			 * display _, or display that there is no last result
 			 */
-			try {
-				built = L"_: " + to_string(variables.at(L"_"));
-			} catch (std::out_of_range &) {
+			if (variables.is_defined(result_slot)) {
+				built = L"_: " + to_string(variables.get(result_slot));
+			} else {
 				built = L"_: no last result";
 			}
 
@@ -257,10 +326,11 @@ void RationalCalculator::register_commands() {
 			 * add every variable except for _ (already accounted for) to the
 			 * string, using built-in to_string for each one
 			 */
-			for (auto & variable : variables) {
-				if (variable.first != L"_") {
-					built.append(L"\n" + variable.first +
-					             L": " + to_string(variable.second));
+			for (auto & slot : variables.get_slots()) {
+				if (slot.second != result_slot &&
+				    variables.is_defined(slot.second)) {
+					built.append(L"\n" + slot.first + L": " +
+					             to_string(variables.get(slot.second)));
 				}
 			}
 
@@ -350,8 +420,12 @@ void RationalCalculator::register_commands() {
 
 	help_pages[L":irrational"] =
 		L"Various utilities related to irrational numbers.\n\n"
-		L"Usage: :irrational <pi/e/golden> <var> - puts pi, e, or the golden"
-		L" ratio into `var`. Uses the current precision as set by :prec.";
+		L"Usage: :irrational <pi/e/golden> <var> - puts pi, e, or the"
+		L" golden ratio into `var`. Uses the current precision as set by"
+		L" :prec.\n"
+		L"Usage: :irrational sqrt <var> - puts the square root of the last"
+		L" result into `var`. Squares of rationals come out exactly, even"
+		L" without a precision.";
 
 	commands[L"irrational"] =
 		[this](const std::vector<Token> & args, bool validate_only = false)
@@ -365,47 +439,253 @@ void RationalCalculator::register_commands() {
 			Token subcommand = args[1];
 
 			if (subcommand.data != L"pi" && subcommand.data != L"e" &&
-			    subcommand.data != L"golden") {
+			    subcommand.data != L"golden" &&
+			    subcommand.data != L"sqrt") {
 				throw CalcASTException(subcommand,
-				                       L"Invalid subcommand (pi/e/golden)");
+				                       L"Invalid subcommand"
+				                       L" (pi/e/golden/sqrt)");
 			}
 
 			Token variable = args[2];
 
 			if (!CONFORMS(variable.data,
-			              CalcTokenizer<math::Rational>::var_chars)) {
+			              CalcTokenizer<Num>::var_chars)) {
 				throw CalcASTException(variable, L"Invalid variable name");
 			}
 
-			if (precision < 0) {
+			/**
+			 * Square roots might come out exactly, which is only known
+			 * once they're tried
+			 */
+			if (precision < 0 && subcommand.data != L"sqrt") {
 				throw CalcASTException(args[0],
 				                       L"Can't calculate perfectly (precision"
 				                       L" must be set, see :help :prec)");
 			}
 
 			if (!validate_only) {
+				bool exact = true;
+
 				try {
 					if (subcommand.data == L"pi") {
-						variables[variable.data] = Irrational::pi(precision);
+						variables[variable.data] = irrational_cache.pi(
+							static_cast<size_t>(precision));
 					} else if (subcommand.data == L"e") {
-						variables[variable.data] = Irrational::e(
+						variables[variable.data] = irrational_cache.e(
 							static_cast<size_t>(precision));
 					} else if (subcommand.data == L"golden") {
-						variables[variable.data] = Irrational::golden_ratio(
-							static_cast<size_t>(precision));
+						variables[variable.data] =
+							irrational_cache.golden_ratio(
+								static_cast<size_t>(precision));
 					} else if (subcommand.data == L"sqrt") {
-						variables[variable.data] = Irrational::sqrt(
-							static_cast<size_t>(precision), variables.at(L"_"));
+						math::Rational value(variables.at(L"_")), root;
+
+						if (precision >= 0) {
+							variables[variable.data] = irrational_cache.sqrt(
+								static_cast<size_t>(precision), value);
+						} else if (Irrational::exact_sqrt(value, root)) {
+							variables[variable.data] = root;
+						} else {
+							exact = false;
+						}
 					}
 				} catch (std::exception & e) {
 					throw CalcASTException(args[1],
 					                       LD::s2wstr(std::string(e.what())));
 				}
+
+				if (!exact) {
+					throw CalcASTException(args[0],
+					                       L"Can't calculate perfectly"
+					                       L" (precision must be set, see"
+					                       L" :help :prec)");
+				}
 			}
 
 			return L"Success!";
 		};
 
+	help_pages[L":cache"] =
+		L":cache - shows or changes how many parsed expressions are"
+		L" remembered. Entering an expression that's been entered before"
+		L" skips straight to evaluating it. Factorials (!, !! and $) are"
+		L" remembered too, so they don't have to be calculated from scratch"
+		L" every time, and so are the digits of pi, e, the golden ratio"
+		L" and square roots, so asking for them again, or for fewer of"
+		L" them, is quick.\n"
+		L"Usage: :cache [size <#>/factorials [<#>]/irrationals [<#>]/clear]\n"
+		L"Example: :cache - shows how full the cache is and how often it"
+		L" was used\n"
+		L"Example: :cache size 1000 - remembers up to 1000 expressions\n"
+		L"Example: :cache size 0 - turns the cache off\n"
+		L"Example: :cache factorials - shows how full the factorial cache"
+		L" is and how often it helped\n"
+		L"Example: :cache factorials 1000000 - lets factorials take up to"
+		L" about 1000000 bytes\n"
+		L"Example: :cache irrationals - shows how full the irrational"
+		L" cache is and how often it helped\n"
+		L"Example: :cache irrationals 0 - turns the irrational cache off\n"
+		L"Example: :cache clear - forgets every expression, factorial and"
+		L" irrational";
+
+	commands[L"cache"] =
+		[this](const std::vector<Token> & args,
+		       bool validate_only = false) -> std::wstring {
+			if (args.size() == 1) {
+				unsigned long lookups = expression_cache.hits +
+				                        expression_cache.misses;
+
+				std::wstring built =
+					             L"Expressions: " +
+					             LD::wtostring(expression_cache.size()) +
+					             L"/" +
+					             LD::wtostring(expression_cache.get_limit()) +
+					             L" cached, " +
+					             LD::wtostring(expression_cache.hits) +
+					             L" hits, " +
+					             LD::wtostring(expression_cache.misses) +
+					             L" misses";
+
+				if (lookups > 0) {
+					built.append(L" (" + LD::wtostring(
+						expression_cache.hits * 100 / lookups) +
+					             L"% hit rate)");
+				}
+
+				return built + L"\n" + factorial_cache_stats() + L"\n" +
+				       irrational_cache_stats();
+			}
+
+			Token subcommand = args[1];
+
+			if (subcommand.data == L"clear") {
+				if (args.size() != 2) {
+					throw CalcASTException(args[2], L"Unexpected argument");
+				}
+
+				if (!validate_only) {
+					invalidate_cache();
+					factorial_cache.clear();
+					irrational_cache.clear();
+				}
+
+				return L"Cache cleared!";
+			} else if (subcommand.data == L"factorials") {
+				if (args.size() == 2) {
+					return factorial_cache_stats();
+				} else if (args.size() != 3) {
+					throw CalcASTException(args[3], L"Unexpected argument");
+				}
+
+				Token proposed = args[2];
+
+				if (proposed.data.find_first_not_of(L"0123456789") !=
+				    std::wstring::npos) {
+					throw CalcASTException(proposed,
+					                       L"Not a positive integer");
+				}
+
+				if (!validate_only) {
+					factorial_cache.set_limit(
+						LD::from_string<unsigned long>(proposed.data));
+				}
+
+				return L"Factorial cache size set!";
+			} else if (subcommand.data == L"irrationals") {
+				if (args.size() == 2) {
+					return irrational_cache_stats();
+				} else if (args.size() != 3) {
+					throw CalcASTException(args[3], L"Unexpected argument");
+				}
+
+				Token proposed = args[2];
+
+				if (proposed.data.find_first_not_of(L"0123456789") !=
+				    std::wstring::npos) {
+					throw CalcASTException(proposed,
+					                       L"Not a positive integer");
+				}
+
+				if (!validate_only) {
+					irrational_cache.set_limit(
+						LD::from_string<unsigned long>(proposed.data));
+				}
+
+				return L"Irrational cache size set!";
+			} else if (subcommand.data == L"size") {
+				if (args.size() != 3) {
+					throw CalcASTException(subcommand,
+					                       L"Expected 1 argument, got " +
+					                       LD::wtostring(args.size() - 2));
+				}
+
+				Token proposed = args[2];
+
+				if (proposed.data.find_first_not_of(L"0123456789") !=
+				    std::wstring::npos) {
+					throw CalcASTException(proposed,
+					                       L"Not a positive integer");
+				}
+
+				if (!validate_only) {
+					expression_cache.set_limit(
+						LD::from_string<unsigned long>(proposed.data));
+				}
+
+				return L"Cache size set!";
+			}
+
+			throw CalcASTException(subcommand,
+			                       L"Invalid subcommand"
+			                       L" (size/factorials/irrationals/clear)");
+		};
+
+	help_pages[L":threads"] =
+		L":threads - set how many threads multiplications of huge numbers"
+		L" are spread across.\n"
+		L"Usage: :threads [#]\n"
+		L"Example: :threads - shows how many threads are used\n"
+		L"Example: :threads 4 - uses 4 threads\n"
+		L"Example: :threads 1 - does everything on one thread\n\n"
+		L"Results are exactly the same no matter how many threads there"
+		L" are. Only numbers around ten thousand digits or longer are"
+		L" split up, so this only matters for things like 10000! or"
+		L" 3^100000.\n"
+		L"# must be a positive integer. It defaults to the number of"
+		L" cores.";
+
+	commands[L"threads"] =
+		[](const std::vector<Token> & args,
+		   bool validate_only = false) -> std::wstring {
+			if (args.size() == 1) {
+				return L"Using " +
+				       LD::wtostring(Multiplication::get_threads()) +
+				       L" thread(s)";
+			} else if (args.size() != 2) {
+				throw CalcASTException(args[2], L"Unexpected argument");
+			}
+
+			Token proposed = args[1];
+
+			if (proposed.data.empty() ||
+			    proposed.data.find_first_not_of(L"0123456789") !=
+			    std::wstring::npos ||
+			    proposed.data.find_first_not_of(L"0") ==
+			    std::wstring::npos) {
+				throw CalcASTException(proposed,
+				                       L"Not a positive integer");
+			} else if (proposed.data.length() > 4) {
+				throw CalcASTException(proposed, L"Too many threads");
+			}
+
+			if (!validate_only) {
+				Multiplication::set_threads(
+					LD::from_string<unsigned>(proposed.data));
+			}
+
+			return L"Thread count set!";
+		};
+
 	help_pages[L":sort"] =
 		L":sort sorts a sequence of numbers in ascending order.\n"
 		L"Example: :sort 3 8 1 6 -> 1, 3, 6, 8";
@@ -413,8 +693,8 @@ void RationalCalculator::register_commands() {
 	commands[L"sort"] =
 		[this](const std::vector<Token> & args, bool validate_only = false)
 			-> std::wstring {
-			std::vector<math::Rational> sorted;
-			std::vector<Token>          args2 = args;
+			std::vector<Num>   sorted;
+			std::vector<Token> args2 = args;
 
 			args2.erase(args2.begin());
 
@@ -432,7 +712,7 @@ void RationalCalculator::register_commands() {
 
 			std::wstring built;
 
-			for (math::Rational & num : sorted) {
+			for (Num & num : sorted) {
 				//built.append(to_string(num) + L", ");
 				built.append(LD::s2wstr(num.to_string()) + L", ");
 			}
@@ -441,7 +721,8 @@ void RationalCalculator::register_commands() {
 		};
 }
 
-void RationalCalculator::generate_commands_help() {
+template <class Num>
+void BasicRationalCalculator<Num>::generate_commands_help() {
 	std::wstring cmds_help =
 		             L"This calculator has a few extra commands (besides :help)"
 		             L" that can either affect how the calculator behaves or"
@@ -460,46 +741,69 @@ void RationalCalculator::generate_commands_help() {
 	help_pages.at(L"starthere").append(L"\n:help commands");
 }
 
-void RationalCalculator::register_functions() {
+template <class Num>
+void BasicRationalCalculator<Num>::register_functions() {
 	help_pages[L"sqrt()"] =
 		L"sqrt() calculates the square root of a value.\n"
 		L"Usage: sqrt(<value>)\n"
 		L"Example: sqrt(4) - calculates the square root of 4. Returns 2.\n"
 		L"Example: sqrt(2) - calculates the square root of 2. Returns"
-		L" approximately 1.4142135623730950488.";
+		L" approximately 1.4142135623730950488.\n"
+		L"Squares of rationals, like 4 or 9/16, have exact roots, which"
+		L" don't need :prec. Anything else needs a precision set.";
 
 	functions[L"sqrt"].insert(
 		// @formatter:off
-		std::make_pair<unsigned, CalcOpFunc(math::Rational)>(
+		std::make_pair<unsigned, CalcOpFunc(Num)>(
 		// @formatter:on
 			1,
-			[](Calculator<math::Rational> * calc, CalcASTElem src,
-			   bool validate_only = false) -> math::Rational {
-				auto * rcalc = reinterpret_cast<RationalCalculator *>(calc);
+			[](Calculator<Num> * calc, const CalcASTElem & src,
+			   bool validate_only = false) -> Num {
+				auto * rcalc =
+					reinterpret_cast<BasicRationalCalculator<Num> *>(calc);
 
-				if (rcalc->precision < 0) {
-					throw CalcASTException(src.token,
-					                       L"Can't calculate perfectly"
-					                       L" (precision must be set, see :help"
-					                       L" :prec)");
+				/**
+				 * Whether the precision is needed depends on the value,
+				 * so that can't be checked until it's known
+				 */
+				if (validate_only) {
+					return rcalc->execute_ast(src.children[0], validate_only);
 				}
 
-				if (!validate_only) {
-					try {
-						return Irrational::sqrt(
-							static_cast<size_t>(rcalc->precision),
-							calc->execute_ast(src.children[0]));
-					} catch (std::exception & e) {
-						throw CalcASTException(calc->get_token(src.children[0]),
-						                       LD::s2wstr(
-							                       std::string(e.what())));
+				/**
+				 * Outside the `try`, so errors in the value keep their own
+				 * token and message
+				 */
+				math::Rational value(calc->execute_ast(src.children[0]));
+
+				try {
+					if (rcalc->precision >= 0) {
+						return rcalc->irrational_cache.sqrt(
+							static_cast<size_t>(rcalc->precision), value);
 					}
-				} else {
-					return rcalc->execute_ast(src.children[0], validate_only);
+
+					/**
+					 * Squares of rationals don't need the precision
+					 */
+					math::Rational root;
+
+					if (Irrational::exact_sqrt(value, root)) {
+						return root;
+					}
+				} catch (std::exception & e) {
+					throw CalcASTException(calc->get_token(src.children[0]),
+					                       LD::s2wstr(std::string(e.what())));
 				}
+
+				throw CalcASTException(src.token,
+				                       L"Can't calculate perfectly"
+				                       L" (precision must be set, see :help"
+				                       L" :prec)");
 			}
 		));
 
+	pure_funcs.insert(L"sqrt");
+
 	help_pages[L"mean()"] =
 		L"mean() calculates the mean of a set of elements.\n"
 		L"Usage: mean(<element,...>)\n"
@@ -507,10 +811,9 @@ void RationalCalculator::register_functions() {
 		L" 15.";
 
 	variadic_funcs[L"mean"] =
-		[](Calculator<math::Rational> * calc, CalcASTElem src,
-		   bool validate_only = false) -> math::Rational {
-			std::valarray<math::Rational> elems(math::Rational(0),
-			                                    src.children.size());
+		[](Calculator<Num> * calc, const CalcASTElem & src,
+		   bool validate_only = false) -> Num {
+			std::valarray<Num> elems(Num(0), src.children.size());
 
 			for (int i = 0; i < src.children.size(); i++) {
 				elems[i] = calc
@@ -520,6 +823,8 @@ void RationalCalculator::register_functions() {
 			return elems.sum() / static_cast<int>(elems.size());
 		};
 
+	pure_funcs.insert(L"mean");
+
 	help_pages[L"stdvar()"] =
 		L"stdvar() calculates the standard variance of a set of elements.\n"
 		L"Usage: stdvar(<sample/population>, <element,...>)\n"
@@ -529,8 +834,8 @@ void RationalCalculator::register_functions() {
 		L" 12.29899614287479072189.";
 
 	variadic_funcs[L"stdvar"] =
-		[](Calculator<math::Rational> * calc, CalcASTElem src,
-		   bool validate_only = false) -> math::Rational {
+		[](Calculator<Num> * calc, const CalcASTElem & src,
+		   bool validate_only = false) -> Num {
 			if (src.children.empty() || (
 				src.children[0].token.data != L"sample" &&
 				src.children[0].token.data != L"population"
@@ -552,18 +857,18 @@ void RationalCalculator::register_functions() {
 				                       L" elements");
 			}
 
-			src.children.erase(src.children.begin());
-
-			std::valarray<math::Rational> elems(math::Rational(0),
-			                                    src.children.size());
+			/**
+			 * The first child is the type, the rest are the elements
+			 */
+			std::valarray<Num> elems(Num(0), src.children.size() - 1);
 
-			for (int i = 0; i < src.children.size(); i++) {
-				elems[i] = calc
+			for (int i = 1; i < src.children.size(); i++) {
+				elems[i - 1] = calc
 					->execute_ast(src.children[i], validate_only);
 			}
 
 			if (!validate_only) {
-				math::Rational mean =
+				Num mean =
 					               elems.sum() /
 					               static_cast<int>(elems.size());
 
@@ -579,9 +884,13 @@ void RationalCalculator::register_functions() {
 
 			return 0.5;
 		};
+
+	pure_funcs.insert(L"stdvar");
+	raw_funcs.insert(L"stdvar");
 }
 
-void RationalCalculator::generate_functions_help() {
+template <class Num>
+void BasicRationalCalculator<Num>::generate_functions_help() {
 	std::wstring funcs_help =
 		             L"This calculator also has a few functions to help you.\n"
 		             L"Each function has its own help page. Functions can be"
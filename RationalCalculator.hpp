@@ -4,19 +4,50 @@
 #include <string>
 
 #include "Calculator.hpp"
+#include "HybridRational.hpp"
+#include "IrrationalCache.hpp"
 #include "boilerplate/precision/math_Rational.h"
 
 /**
- * A subclass of [[Calculator]] that deals exclusively with [[math::Rational]]s.
+ * A subclass of [[Calculator]] that deals exclusively with rationals.
  *
  * Includes some extra commands for controlling precision, as well as the
  * required subclass implementations of [[Calculator::is_int]] and
  * [[Calculator::to_string]].
+ *
+ * @tparam Num [[math::Rational]], or anything that acts like one and can be
+ * converted to and from one, like [[HybridRational]]. See
+ * [[RationalCalculator]] and [[HybridCalculator]].
  */
-class RationalCalculator : public Calculator<math::Rational> {
+template <class Num>
+class BasicRationalCalculator : public Calculator<Num> {
+	/**
+	 * [[Calculator]] depends on `Num`, so its members aren't found without
+	 * these
+	 */
+	protected:
+	using Calculator<Num>::tk_debug;
+	using Calculator<Num>::tk_debug_force;
+	using Calculator<Num>::ast_debug;
+	using Calculator<Num>::ast_debug_force;
+	using Calculator<Num>::expression_cache;
+
+	public:
+	using Calculator<Num>::variables;
+	using Calculator<Num>::result_slot;
+	using Calculator<Num>::functions;
+	using Calculator<Num>::variadic_funcs;
+	using Calculator<Num>::pure_funcs;
+	using Calculator<Num>::raw_funcs;
+	using Calculator<Num>::factorial_cache;
+	using Calculator<Num>::help_pages;
+	using Calculator<Num>::commands;
+	using Calculator<Num>::invalidate_cache;
+
+	private:
 	/**
 	 * The precision rationals will be displayed as in
-	 * [[RationalCalculator::to_string]].
+	 * [[BasicRationalCalculator::to_string]].
 	 */
 	long precision = -1;
 
@@ -32,7 +63,7 @@ class RationalCalculator : public Calculator<math::Rational> {
 	 * @param num The number to check,
 	 * @return Whether it's an integer.
 	 */
-	bool is_int(const math::Rational & num) override;
+	bool is_int(const Num & num) override;
 
 	/**
 	 * Commatizes a string. For example, turns 100000 into 100,000 and 1000 into
@@ -43,6 +74,22 @@ class RationalCalculator : public Calculator<math::Rational> {
 	 */
 	std::wstring commatize_str(const std::wstring & str);
 
+	/**
+	 * Describes how full [[Calculator::factorial_cache]] is and how often
+	 * it helped, for `:cache`.
+	 *
+	 * @return
+	 */
+	std::wstring factorial_cache_stats();
+
+	/**
+	 * Describes how full [[BasicRationalCalculator::irrational_cache]] is
+	 * and how often it helped, for `:cache`.
+	 *
+	 * @return
+	 */
+	std::wstring irrational_cache_stats();
+
 	/**
 	 * Registers commands and their corresponding help pages.
 	 */
@@ -64,20 +111,37 @@ class RationalCalculator : public Calculator<math::Rational> {
 	void generate_functions_help();
 
 	public:
+	/**
+	 * Digits of pi, e, the golden ratio and square roots worked out so
+	 * far, used by `:irrational` and `sqrt()`.
+	 */
+	IrrationalCache irrational_cache;
+
 	/**
 	 * Constructor. Set up some new commands, make some amends to existing help
 	 * pages, create some new ones, etc.
 	 */
-	RationalCalculator();
+	BasicRationalCalculator();
 
 	/**
-	 * Convert a [[math::Rational]] to a string, using the current
-	 * [[RationalCalculator::precision]] setting.
+	 * Convert a rational to a string, using the current
+	 * [[BasicRationalCalculator::precision]] setting.
 	 *
 	 * @param num The number to convert.
 	 * @return
 	 */
-	std::wstring to_string(const math::Rational & num) override;
+	std::wstring to_string(const Num & num) override;
 };
 
+/**
+ * The calculator, with every number a [[math::Rational]]
+ */
+typedef BasicRationalCalculator<math::Rational> RationalCalculator;
+
+/**
+ * The calculator, with every number a [[HybridRational]]. Same results as
+ * [[RationalCalculator]], but small numbers don't allocate.
+ */
+typedef BasicRationalCalculator<HybridRational> HybridCalculator;
+
 #endif //CALCULATOR_RATIONALCALCULATOR_HPP
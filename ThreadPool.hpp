@@ -0,0 +1,282 @@
+#ifndef CALCULATOR_THREADPOOL_HPP
+#define CALCULATOR_THREADPOOL_HPP
+
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * A fixed number of threads that share jobs by work stealing.
+ *
+ * Every thread has its own queue of jobs. Jobs a thread hands out go on its
+ * own queue, and it takes them back newest first, so a thread working
+ * through a tree of jobs stays on the part of the tree it just split. A
+ * thread with nothing left to do takes the oldest job from somebody else's
+ * queue, which is the biggest piece of work that thread hasn't gotten to.
+ *
+ * The thread that hands the jobs out counts as one of the threads, so a pool
+ * of 1 has no workers at all and runs everything itself. Threads that are
+ * waiting for jobs to finish run other jobs in the meantime, which means
+ * jobs can hand out more jobs and wait for them without the pool running out
+ * of threads.
+ */
+class ThreadPool {
+	struct Queue {
+		std::mutex                        mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	/**
+	 * One for every worker, plus one (the first) for threads that aren't
+	 * part of the pool
+	 */
+	std::vector<std::unique_ptr<Queue>> queues;
+
+	std::vector<std::thread> workers;
+
+	/**
+	 * How many jobs are queued, across every queue
+	 */
+	std::atomic<size_t> queued {0};
+
+	/**
+	 * Workers sleep on this when there's nothing to steal
+	 */
+	std::mutex              sleep_mutex;
+	std::condition_variable wake;
+
+	bool stopping = false;
+
+	/**
+	 * @return Which queue belongs to this thread, for this pool
+	 */
+	size_t own_queue() {
+		return worker_pool() == this ? worker_index() : 0;
+	}
+
+	static ThreadPool *& worker_pool() {
+		static thread_local ThreadPool * pool = nullptr;
+
+		return pool;
+	}
+
+	static size_t & worker_index() {
+		static thread_local size_t index = 0;
+
+		return index;
+	}
+
+	/**
+	 * Takes the newest job from queue `index`, or the oldest if `steal`
+	 */
+	bool take(size_t index, bool steal, std::function<void()> & job) {
+		Queue & queue = * queues[index];
+
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.jobs.empty()) {
+			return false;
+		}
+
+		if (steal) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		} else {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+
+		queued--;
+
+		return true;
+	}
+
+	/**
+	 * Runs a job from this thread's queue, or failing that, one stolen
+	 * from another queue.
+	 *
+	 * @return Whether there was one
+	 */
+	bool run_one() {
+		size_t own = own_queue();
+
+		std::function<void()> job;
+
+		if (!take(own, false, job)) {
+			bool found = false;
+
+			for (size_t i = 1; i < queues.size() && !found; i++) {
+				found = take((own + i) % queues.size(), true, job);
+			}
+
+			if (!found) {
+				return false;
+			}
+		}
+
+		job();
+
+		return true;
+	}
+
+	/**
+	 * What every worker does until the pool is destroyed
+	 */
+	void work(size_t index) {
+		worker_pool()  = this;
+		worker_index() = index;
+
+		while (true) {
+			if (run_one()) {
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+
+			wake.wait(lock, [this]() {
+				return stopping || queued > 0;
+			});
+
+			if (stopping && queued == 0) {
+				return;
+			}
+		}
+	}
+
+	/**
+	 * Queues `job` on this thread's queue
+	 */
+	std::future<void> submit(const std::function<void()> & job) {
+		auto task = std::make_shared<std::packaged_task<void()>>(job);
+		std::future<void> future = task->get_future();
+
+		Queue & queue = * queues[own_queue()];
+
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			queue.jobs.emplace_back([task]() {
+				(* task)();
+			});
+
+			queued++;
+		}
+
+		/**
+		 * Taking the lock means a worker that just found nothing is either
+		 * not asleep yet, and will see `queued`, or asleep, and will be
+		 * woken
+		 */
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+
+		wake.notify_one();
+
+		return future;
+	}
+
+	/**
+	 * Waits for a job from [[ThreadPool::submit]], running other jobs while
+	 * it isn't done
+	 */
+	void wait(std::future<void> & future) {
+		while (future.wait_for(std::chrono::seconds(0)) !=
+		       std::future_status::ready) {
+			if (!run_one()) {
+				future.wait_for(std::chrono::microseconds(100));
+			}
+		}
+
+		future.get();
+	}
+
+	public:
+	/**
+	 * @param threads How many threads to use, including the one that runs
+	 * [[ThreadPool::run]]
+	 */
+	explicit ThreadPool(unsigned threads) {
+		for (unsigned i = 0; i < std::max(threads, 1u); i++) {
+			queues.emplace_back(new Queue());
+		}
+
+		for (unsigned i = 1; i < threads; i++) {
+			workers.emplace_back(& ThreadPool::work, this, i);
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+
+			stopping = true;
+		}
+
+		wake.notify_all();
+
+		for (std::thread & worker : workers) {
+			worker.join();
+		}
+	}
+
+	/**
+	 * @return How many threads there are, including the caller's
+	 */
+	unsigned size() const {
+		return static_cast<unsigned>(workers.size()) + 1;
+	}
+
+	/**
+	 * Runs every job, spread across the pool, and returns once all of them
+	 * are done. The first job runs on this thread. If any jobs throw, the
+	 * rest still finish, and then the first exception is rethrown.
+	 *
+	 * @param jobs The jobs to run
+	 */
+	void run(const std::vector<std::function<void()>> & jobs) {
+		std::vector<std::future<void>> futures;
+
+		for (size_t i = 1; i < jobs.size(); i++) {
+			futures.push_back(submit(jobs[i]));
+		}
+
+		std::exception_ptr error;
+
+		try {
+			if (!jobs.empty()) {
+				jobs[0]();
+			}
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		for (std::future<void> & future : futures) {
+			try {
+				wait(future);
+			} catch (...) {
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+};
+
+#endif //CALCULATOR_THREADPOOL_HPP
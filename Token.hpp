@@ -26,6 +26,15 @@ struct Token {
 	 */
 	unsigned long pos;
 
+	/**
+	 * For operators, the index of the operator in
+	 * [[CalcOperators::binary_ops]] (TK_OPERATOR) or
+	 * [[CalcOperators::unary_ops]] (TK_UOPERATOR). The tokenizer fills this
+	 * in so nothing after it has to look operators up by string. -1 if
+	 * unknown.
+	 */
+	int op = -1;
+
 	/**
 	 * Create a new token.
 	 *
@@ -0,0 +1,962 @@
+/**
+ * Benchmarks for the calculator's internals.
+ *
+ * Usage: benchmark [name...]
+ *
+ * Runs every benchmark if no names are given. Build with optimizations
+ * (-DCMAKE_BUILD_TYPE=Release) or the numbers won't mean much.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boilerplate/ld_boilerplate.hpp"
+
+#include "RationalCalculator.cpp"
+
+/**
+ * [[BasicRationalCalculator]], but with the individual pipeline steps exposed
+ * so they can be timed separately.
+ */
+template <class Num>
+	class BasicBenchCalculator : public BasicRationalCalculator<Num> {
+		public:
+		using Calculator<Num>::tokenize;
+		using Calculator<Num>::get_ast;
+	};
+
+typedef BasicBenchCalculator<math::Rational> BenchCalculator;
+
+/**
+ * Runs `func` `iterations` times and prints how long each run took on
+ * average.
+ *
+ * @param name What to call this in the output
+ * @param iterations How many times to run `func`
+ * @param func The thing to time
+ * @return Average nanoseconds per run
+ */
+double bench(const std::string & name, unsigned long iterations,
+             const std::function<void()> & func) {
+	auto start = std::chrono::steady_clock::now();
+
+	for (unsigned long i = 0; i < iterations; i++) {
+		func();
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+	            iterations;
+
+	std::cout << "  " << LD::w2str(LD::pad(LD::s2wstr(name), 40)) << ns
+	          << " ns/run (" << iterations << " runs)" << std::endl;
+
+	return ns;
+}
+
+/**
+ * The test cases from the top of main.cpp (minus the huge one), plus a few
+ * that use variables and functions.
+ */
+std::vector<std::wstring> expressions {
+	L"10(4)-2(4^2/4)/2/(1/2)+9",
+	L"-10/(20/2^2*5/5)*8-2",
+	L"-4--9(3-(3^3+9))",
+	L"((-84/-7)^3--9)*-11+-11",
+	L"((-96/-4)^2-11)*-3+-3",
+	L"((90/5)^3-10)*2+2",
+	L"((-96/-4)^3--11)*-4+-4",
+	L"-6--4(-5-(-5^3+-4))",
+	L"x * (y + 3) - x / y",
+	L"mean(x, y, 3, 4) * 2"
+};
+
+/**
+ * Tree walker ([[Calculator::execute_ast]]) vs. bytecode
+ * ([[Calculator::execute_program]]) on already-parsed expressions.
+ */
+void bench_bytecode() {
+	BenchCalculator calc;
+
+	calc.execute(L"x = 7");
+	calc.execute(L"y = 3/4");
+
+	double tree_total = 0, bytecode_total = 0;
+
+	for (const std::wstring & input : expressions) {
+		CalcASTElem                 ast     = calc.get_ast(
+			calc.tokenize(input));
+		CalcProgram<math::Rational> program = calc.compile(ast);
+
+		std::cout << LD::w2str(input) << std::endl;
+
+		tree_total += bench("tree walker", 20000, [&]() {
+			calc.execute_ast(ast);
+		});
+
+		bytecode_total += bench("bytecode", 20000, [&]() {
+			calc.execute_program(program);
+		});
+
+		bench("compile", 20000, [&]() {
+			calc.compile(ast);
+		});
+	}
+
+	std::cout << "total: tree walker " << tree_total << " ns, bytecode "
+	          << bytecode_total << " ns (" << tree_total / bytecode_total
+	          << "x)" << std::endl;
+}
+
+/**
+ * Inputs that parse fine but fail to compile or evaluate, like the ones the
+ * live validator sees while something is being typed.
+ */
+std::vector<std::wstring> error_expressions {
+	L"y + 1",
+	L"x * (y - 2)",
+	L"10 / (3 - 3)",
+	L"x / 0",
+	L"3 = x",
+	L"mea(1, 2)",
+	L"sqrt(1, 2)",
+	L"(-1)!"
+};
+
+/**
+ * Validating inputs that fail, through the throwing API
+ * ([[Calculator::compile]] and [[Calculator::execute_program]]) vs. the
+ * result API ([[Calculator::try_evaluate]]).
+ */
+void bench_errors() {
+	BenchCalculator calc;
+
+	calc.execute(L"x = 7");
+
+	double throwing_total = 0, result_total = 0;
+
+	for (const std::wstring & input : error_expressions) {
+		CalcASTElem ast = calc.get_ast(calc.tokenize(input));
+
+		std::cout << LD::w2str(input) << std::endl;
+
+		throwing_total += bench("throwing", 20000, [&]() {
+			try {
+				calc.execute_program(calc.compile(ast), true);
+			} catch (CalcASTException &) {}
+		});
+
+		result_total += bench("result", 20000, [&]() {
+			calc.try_evaluate(ast, true);
+		});
+	}
+
+	std::cout << "total: throwing " << throwing_total << " ns, result "
+	          << result_total << " ns (" << throwing_total / result_total
+	          << "x)" << std::endl;
+}
+
+/**
+ * Inputs as they'd be checked while typing
+ */
+std::vector<std::wstring> validate_expressions {
+	L"x ^ (100!)",
+	L"(2 + 3) * x / 4 - 1",
+	L"mean(1, 2, 3, x, 5, 6)",
+	L"(y = 2) + y * x",
+	L"x / 0"
+};
+
+/**
+ * Validating by compiling and running in `validate_only` mode
+ * ([[Calculator::try_compile]] and [[Calculator::try_execute_program]]) vs.
+ * validating without running anything ([[Calculator::try_validate]]).
+ */
+void bench_validate() {
+	BenchCalculator calc;
+
+	calc.execute(L"x = 7");
+
+	double evaluate_total = 0, validate_total = 0;
+
+	for (const std::wstring & input : validate_expressions) {
+		std::vector<math::Rational> constants;
+		CalcASTElem ast = calc.get_ast(calc.tokenize(input), nullptr,
+		                               & constants);
+
+		std::cout << LD::w2str(input) << std::endl;
+
+		evaluate_total += bench("evaluate", 20000, [&]() {
+			CalcResult<CalcProgram<math::Rational>> program =
+				calc.try_compile(ast, constants);
+
+			if (program.ok()) {
+				calc.try_execute_program(program.get(), true);
+			}
+		});
+
+		validate_total += bench("validate", 20000, [&]() {
+			calc.try_validate(ast, & constants);
+		});
+	}
+
+	std::cout << "total: evaluate " << evaluate_total << " ns, validate "
+	          << validate_total << " ns (" << evaluate_total / validate_total
+	          << "x)" << std::endl;
+}
+
+/**
+ * Power towers, which are evaluated from the right like `^` is
+ */
+std::vector<std::pair<std::string, std::vector<math::Rational>>> towers {
+	{"2^3^4",       {2, 3, 4}},
+	{"3^3^3",       {3, 3, 3}},
+	{"7^2^10",      {7, 2, 10}},
+	{"(2/3)^2^9",   {math::Rational(2, 3), 2, 9}},
+	{"2^2^2^2^2",   {2, 2, 2, 2, 2}},
+	{"10^-(2^10)",  {10, -math::Rational(1024)}}
+};
+
+/**
+ * Raising the numerator and denominator with [[LD::ipow]] and building a new
+ * [[math::Rational]], like the `^` operator used to, vs. the exponentiation
+ * kernel.
+ */
+void bench_power() {
+	BenchCalculator calc;
+
+	auto ipow = [](math::Rational & lhs, const math::Rational & rhs) {
+		lhs = math::Rational(LD::ipow(lhs.numerator(), rhs.numerator()),
+		                     LD::ipow(lhs.denominator(), rhs.numerator()));
+	};
+
+	auto kernel = [&](math::Rational & lhs, const math::Rational & rhs) {
+		CalcOperations<math::Rational>::BinaryKernels::exponentiation(
+			& calc, lhs, rhs, false);
+	};
+
+	for (auto & tower : towers) {
+		const std::vector<math::Rational> & values = tower.second;
+
+		std::cout << tower.first << std::endl;
+
+		/**
+		 * The old way can't do negative exponents
+		 */
+		if (values.back() > 0) {
+			bench("ipow", 20, [&]() {
+				math::Rational result = values.back();
+
+				for (size_t i = values.size() - 1; i-- > 0;) {
+					math::Rational base = values[i];
+
+					ipow(base, result);
+					result = base;
+				}
+			});
+		}
+
+		bench("kernel", 20, [&]() {
+			math::Rational result = values.back();
+
+			for (size_t i = values.size() - 1; i-- > 0;) {
+				math::Rational base = values[i];
+
+				kernel(base, result);
+				result = base;
+			}
+		});
+	}
+}
+
+/**
+ * Multiplying [[math::Rational]]s one at a time, like `!` used to, vs. the
+ * factorial kernel, from 10! up to 100000!. The old way is only timed while
+ * it finishes in reasonable time.
+ */
+void bench_factorial() {
+	BenchCalculator calc;
+
+	for (std::uint64_t n = 10; n <= 100000; n *= 10) {
+		unsigned long iterations = n <= 1000 ? 100 : n <= 10000 ? 5 : 1;
+
+		std::cout << n << "!" << std::endl;
+
+		if (n <= 10000) {
+			bench("loop", iterations, [&]() {
+				math::Rational factored = 1;
+
+				for (math::Rational i(1); i <= math::Rational(
+					math::Integer(IntegerMath::from_word(n)), 1); i++) {
+					factored *= i;
+				}
+			});
+		}
+
+		bench("kernel", iterations, [&]() {
+			math::Rational num(math::Integer(IntegerMath::from_word(n)), 1);
+
+			CalcOperations<math::Rational>::UnaryKernels::factorial(
+				& calc, num, false);
+		});
+	}
+}
+
+/**
+ * The old loops for `!!` and `$`, one [[math::Rational]] at a time, vs. their
+ * kernels. The old way is only timed while it finishes in reasonable time.
+ */
+void bench_factorials() {
+	BenchCalculator calc;
+
+	auto rational = [](std::uint64_t n) {
+		return math::Rational(math::Integer(IntegerMath::from_word(n)), 1);
+	};
+
+	for (std::uint64_t n = 10; n <= 100000; n *= 10) {
+		unsigned long iterations = n <= 1000 ? 100 : n <= 10000 ? 5 : 1;
+
+		std::cout << n << "!!" << std::endl;
+
+		if (n <= 10000) {
+			bench("loop", iterations, [&]() {
+				math::Rational num = rational(n), factored = 1;
+
+				for (math::Rational i(1); i <= num; i++) {
+					if (i.numerator() % 2 == num.numerator() % 2) {
+						factored *= i;
+					}
+				}
+			});
+		}
+
+		bench("kernel", iterations, [&]() {
+			math::Rational num = rational(n);
+
+			CalcOperations<math::Rational>::UnaryKernels::dbl_factorial(
+				& calc, num, false);
+		});
+	}
+
+	/**
+	 * These get big much faster, 500$ has about 300,000 digits
+	 */
+	for (std::uint64_t n : {10, 50, 100, 250, 500}) {
+		unsigned long iterations = n <= 100 ? 20 : 1;
+
+		std::cout << n << "$" << std::endl;
+
+		bench("loop", iterations, [&]() {
+			math::Rational num = rational(n), factored = 1, factorial = 1;
+
+			for (math::Rational i(1); i <= num; i++) {
+				factorial *= i;
+				factored *= factorial;
+			}
+		});
+
+		bench("kernel", iterations, [&]() {
+			math::Rational num = rational(n);
+
+			CalcOperations<math::Rational>::UnaryKernels::super_factorial(
+				& calc, num, false);
+		});
+	}
+}
+
+/**
+ * Overlapping factorials, like a session of someone poking at them would
+ * have
+ */
+std::vector<std::uint64_t> memo_sequence {
+	5000, 5200, 5100, 6000, 5999, 7000, 6500, 7000, 8000, 7500, 9000, 8800
+};
+
+/**
+ * The factorial kernels with [[Calculator::factorial_cache]] turned off vs.
+ * on, over [[memo_sequence]].
+ */
+void bench_memo() {
+	for (unsigned long limit : {0ul, 16ul * 1024 * 1024}) {
+		BenchCalculator calc;
+
+		calc.factorial_cache.set_limit(limit);
+
+		std::cout << (limit ? "cached" : "uncached") << std::endl;
+
+		bench("!", 1, [&]() {
+			for (std::uint64_t n : memo_sequence) {
+				math::Rational num(math::Integer(IntegerMath::from_word(n)), 1);
+
+				CalcOperations<math::Rational>::UnaryKernels::factorial(
+					& calc, num, false);
+			}
+		});
+
+		bench("!!", 1, [&]() {
+			for (std::uint64_t n : memo_sequence) {
+				math::Rational num(math::Integer(IntegerMath::from_word(n)), 1);
+
+				CalcOperations<math::Rational>::UnaryKernels::dbl_factorial(
+					& calc, num, false);
+			}
+		});
+
+		std::cout << "  " << calc.factorial_cache.hits << " hits, "
+		          << calc.factorial_cache.misses << " misses" << std::endl;
+	}
+}
+
+/**
+ * The test cases from the top of main.cpp, all of them this time
+ */
+std::vector<std::pair<std::wstring, unsigned long>> main_expressions {
+	{L"10(4)-2(4^2/4)/2/(1/2)+9", 20000},
+	{L"-10/(20/2^2*5/5)*8-2",     20000},
+	{L"-4--9(3-(3^3+9))",         20000},
+	{L"((-84/-7)^3--9)*-11+-11",  20000},
+	{L"((-96/-4)^2-11)*-3+-3",    20000},
+	{L"((90/5)^3-10)*2+2",        20000},
+	{L"((-96/-4)^3--11)*-4+-4",   20000},
+	{L"-6--4(-5-(-5^3+-4))",      20000},
+	{L"((3!)!)!^2",               200}
+};
+
+/**
+ * Evaluates `input` `iterations` times without folding it first, and prints
+ * the result
+ *
+ * @return Average nanoseconds per run
+ */
+template <class Num>
+	double bench_evaluate(const std::string & name, const std::wstring & input,
+	                      unsigned long iterations) {
+		BasicBenchCalculator<Num> calc;
+
+		CalcProgram<Num> program = calc.compile(
+			calc.get_ast(calc.tokenize(input)));
+
+		return bench(name, iterations, [&]() {
+			calc.to_string(calc.execute_program(program));
+		});
+	}
+
+/**
+ * [[RationalCalculator]] vs. [[HybridCalculator]], evaluating and printing
+ * [[main_expressions]].
+ */
+void bench_hybrid() {
+	double rational_total = 0, hybrid_total = 0;
+
+	for (auto & expression : main_expressions) {
+		std::cout << LD::w2str(expression.first) << std::endl;
+
+		rational_total += bench_evaluate<math::Rational>(
+			"rational", expression.first, expression.second);
+
+		hybrid_total += bench_evaluate<HybridRational>(
+			"hybrid", expression.first, expression.second);
+	}
+
+	std::cout << "total: rational " << rational_total << " ns, hybrid "
+	          << hybrid_total << " ns (" << rational_total / hybrid_total
+	          << "x)" << std::endl;
+}
+
+/**
+ * Evaluates `input` before and after [[CalcFlatten::flatten]]
+ */
+template <class Num>
+	void bench_chain(const std::wstring & input, unsigned long iterations) {
+		BasicBenchCalculator<Num> calc;
+
+		CalcASTElem      ast       = calc.get_ast(calc.tokenize(input));
+		CalcProgram<Num> binary    = calc.compile(ast);
+		CalcProgram<Num> flattened = calc.compile(CalcFlatten::flatten(ast));
+
+		bench("binary", iterations, [&]() {
+			calc.execute_program(binary);
+		});
+
+		bench("flattened", iterations, [&]() {
+			calc.execute_program(flattened);
+		});
+	}
+
+/**
+ * Long chains of + and *, as a tree of binary operations vs. one n-ary
+ * operation, with both number types
+ */
+void bench_flatten() {
+	std::wstring sum = L"1", product = L"1";
+
+	for (int i = 2; i <= 30; i++) {
+		sum.append(L"+1/" + std::to_wstring(i));
+		product.append((i % 2 ? L"*" : L"/") + std::to_wstring(i));
+	}
+
+	for (const std::wstring & input : {sum, product}) {
+		std::cout << LD::w2str(input.substr(0, 20)) << "..." << std::endl;
+		std::cout << "rational" << std::endl;
+
+		bench_chain<math::Rational>(input, 5000);
+
+		std::cout << "hybrid" << std::endl;
+
+		bench_chain<HybridRational>(input, 5000);
+	}
+}
+
+/**
+ * Times `func` with 1 thread, then 2, 4 and so on up to the number of cores,
+ * and prints how much faster each is than 1 thread.
+ */
+void bench_scaling(unsigned long iterations,
+                   const std::function<void()> & func) {
+	unsigned previous = Multiplication::get_threads();
+	unsigned cores    = std::max(std::thread::hardware_concurrency(), 1u);
+	double   single   = 0;
+
+	for (unsigned count = 1;; count = std::min(count * 2, cores)) {
+		Multiplication::set_threads(count);
+
+		double ns = bench(std::to_string(count) + " thread(s)", iterations,
+		                  func);
+
+		if (count == 1) {
+			single = ns;
+		} else {
+			std::cout << "    " << single / ns << "x" << std::endl;
+		}
+
+		if (count == cores) {
+			break;
+		}
+	}
+
+	Multiplication::set_threads(previous);
+}
+
+/**
+ * [[Multiplication]] on numbers of a few sizes, to see how well it scales.
+ * The library's own multiplication is timed too, where it finishes in
+ * reasonable time.
+ */
+void bench_threads() {
+	/**
+	 * 3^n has about n * 0.05 limbs
+	 */
+	for (unsigned long exp : {20000ul, 200000ul, 2000000ul}) {
+		math::Unsigned lhs = IntegerMath::pow(math::Unsigned(3),
+		                                      IntegerMath::from_word(exp));
+		math::Unsigned rhs = lhs + 1;
+		unsigned long  iterations = exp <= 20000 ? 50 : exp <= 200000 ? 5 : 1;
+
+		std::cout << "3^" << exp << " * (3^" << exp << " + 1)" << std::endl;
+
+		if (exp <= 200000) {
+			bench("library", iterations, [&]() {
+				lhs * rhs;
+			});
+		}
+
+		bench_scaling(iterations, [&]() {
+			Multiplication::multiply(lhs, rhs);
+		});
+	}
+}
+
+/**
+ * The factorial kernels on big numbers, with the factorial cache off so
+ * every run starts from scratch, to see how well the product trees scale.
+ */
+void bench_tree() {
+	BenchCalculator calc;
+
+	calc.factorial_cache.set_limit(0);
+
+	auto rational = [](std::uint64_t n) {
+		return math::Rational(math::Integer(IntegerMath::from_word(n)), 1);
+	};
+
+	std::cout << "200000!" << std::endl;
+
+	bench_scaling(1, [&]() {
+		math::Rational num = rational(200000);
+
+		CalcOperations<math::Rational>::UnaryKernels::factorial(
+			& calc, num, false);
+	});
+
+	std::cout << "200000!!" << std::endl;
+
+	bench_scaling(1, [&]() {
+		math::Rational num = rational(200000);
+
+		CalcOperations<math::Rational>::UnaryKernels::dbl_factorial(
+			& calc, num, false);
+	});
+
+	std::cout << "1000$" << std::endl;
+
+	bench_scaling(1, [&]() {
+		math::Rational num = rational(1000);
+
+		CalcOperations<math::Rational>::UnaryKernels::super_factorial(
+			& calc, num, false);
+	});
+}
+
+/**
+ * [[Decimal::to_string]] vs. the library's own `to_string`, on powers of 3
+ * from about a thousand digits to about a million. The library is only timed
+ * up to about a hundred thousand digits, and both have to give the same
+ * string.
+ */
+void bench_decimal() {
+	for (std::uint64_t n = 2100; n <= 2100000; n *= 10) {
+		math::Unsigned num = IntegerMath::pow(math::Unsigned(3),
+		                                      math::Unsigned(n));
+		std::string    fast, slow;
+
+		unsigned long iterations = n <= 21000 ? 20 : 1;
+
+		std::cout << "3^" << n << std::endl;
+
+		double ns = bench("decimal", iterations, [&]() {
+			fast = Decimal::to_string(num);
+		});
+
+		std::cout << "    " << fast.size() * 1e9 / ns << " digits/s"
+		          << std::endl;
+
+		if (n <= 210000) {
+			ns = bench("library", iterations, [&]() {
+				slow = num.to_string();
+			});
+
+			std::cout << "    " << slow.size() * 1e9 / ns << " digits/s"
+			          << std::endl;
+
+			if (fast != slow) {
+				std::cout << "    MISMATCH" << std::endl;
+			}
+		}
+	}
+}
+
+/**
+ * [[Decimal::to_string]] vs. the library's `to_string` at fixed precision,
+ * on a fraction with a few thousand digit denominator, from a thousand
+ * digits after the point to a million. The library is only timed up to a
+ * hundred thousand digits, and both have to give the same string.
+ */
+void bench_precision() {
+	math::Rational num(
+		math::Integer(IntegerMath::pow(math::Unsigned(3),
+		                               IntegerMath::from_word(3000))),
+		math::Integer(IntegerMath::pow(math::Unsigned(7),
+		                               IntegerMath::from_word(2000))));
+
+	for (size_t digits = 1000; digits <= 1000000; digits *= 10) {
+		std::string fast, slow;
+
+		unsigned long iterations = digits <= 10000 ? 5 : 1;
+
+		std::cout << digits << " digits" << std::endl;
+
+		bench("newton", iterations, [&]() {
+			fast = Decimal::to_string(num.numerator(), num.denominator(),
+			                          digits);
+		});
+
+		if (digits <= 100000) {
+			bench("library", iterations, [&]() {
+				slow = num.to_string(digits);
+			});
+
+			if (fast != slow) {
+				std::cout << "    MISMATCH" << std::endl;
+			}
+		}
+	}
+}
+
+/**
+ * The spigot [[Irrational::pi]] used to use, from
+ * https://rosettacode.org/wiki/Pi#C.23, which makes one digit at a time.
+ */
+struct PiSpigot {
+	math::Integer k  = 1,
+	              l  = 3,
+	              n  = 0,
+	              q  = 10,
+	              r  = -30,
+	              t  = 1,
+	              nr = -30;
+
+	math::Unsigned next_digit() {
+		while (true) {
+			math::Integer tn = t * n;
+
+			if (4 * q + r - t < tn) {
+				math::Integer nn = n;
+				nr = (r - tn) * 10;
+				n  = (q * 3 + r) * 10 / t - 10 * n;
+				q *= 10;
+				r  = nr;
+
+				return nn.abs();
+			} else {
+				t *= l;
+				nr = (q * 2 + r) * l;
+				n  = (q * (k * 7) + 2 + r * l) / t;
+				q *= k;
+				l += 2;
+				k++;
+			}
+
+			r = nr;
+		}
+	}
+};
+
+/**
+ * [[Irrational::pi_digits]] from a thousand digits to a million, on 1
+ * thread and up. The old spigot is only timed at a thousand digits, since it
+ * takes far too long after that. Turning the digits into a [[math::Rational]]
+ * isn't timed, since that's the library's GCD either way.
+ */
+void bench_pi() {
+	for (size_t digits = 1000; digits <= 1000000; digits *= 10) {
+		unsigned long iterations = digits <= 10000 ? 5 : 1;
+
+		std::cout << digits << " digits" << std::endl;
+
+		if (digits <= 1000) {
+			bench("spigot", 1, [&]() {
+				PiSpigot    spigot;
+				std::string built = "3.";
+
+				for (size_t i = 0; i < digits; i++) {
+					built.append(spigot.next_digit().to_string());
+				}
+			});
+		}
+
+		bench_scaling(iterations, [&]() {
+			Irrational::pi_digits(digits);
+		});
+	}
+}
+
+/**
+ * [[Irrational::e_digits]] from a thousand digits to a million, on 1 thread
+ * and up, and the old loop that added up [[math::Rational]]s at a thousand
+ * digits.
+ */
+void bench_e() {
+	for (size_t digits = 1000; digits <= 1000000; digits *= 10) {
+		unsigned long iterations = digits <= 10000 ? 5 : 1;
+
+		std::cout << digits << " digits" << std::endl;
+
+		if (digits <= 1000) {
+			bench("loop", 1, [&]() {
+				math::Rational result = 2;
+				math::Unsigned fact   = 1;
+				math::Unsigned goal   = LD::ipow<math::Unsigned>(10, digits);
+
+				for (math::Unsigned i = 2; fact <= goal; i++) {
+					fact *= i;
+					result += math::Rational(1, fact);
+				}
+
+				result.round(digits);
+			});
+		}
+
+		bench_scaling(iterations, [&]() {
+			Irrational::e_digits(digits);
+		});
+	}
+}
+
+/**
+ * [[Irrational::golden_digits]] from a thousand digits to a hundred
+ * thousand, and the old continued fraction loop at a thousand digits.
+ */
+void bench_golden() {
+	for (size_t digits = 1000; digits <= 100000; digits *= 10) {
+		unsigned long iterations = digits <= 10000 ? 5 : 1;
+
+		std::cout << digits << " digits" << std::endl;
+
+		if (digits <= 1000) {
+			bench("loop", 1, [&]() {
+				math::Rational result = 1,
+				               last   = 0,
+				               error  = math::Rational(
+					               1, LD::ipow<math::Unsigned>(10, digits));
+
+				while (LD::abs(result - last) > error) {
+					last   = result;
+					result = 1 + 1 / result;
+				}
+
+				result.round(digits);
+			});
+		}
+
+		bench("isqrt", iterations, [&]() {
+			Irrational::golden_digits(digits);
+		});
+	}
+}
+
+/**
+ * [[Irrational::sqrt_digits]] for a small number and a big one, and the old
+ * Newton's method on [[math::Rational]]s for sqrt(2) at a hundred digits.
+ * The old way starts from the number itself and its denominators square
+ * every step, so it never finishes for the big one.
+ */
+void bench_sqrt() {
+	std::cout << "sqrt(2), 100 digits" << std::endl;
+
+	bench("rational", 1, [&]() {
+		math::Rational src    = 2,
+		               result = src,
+		               last,
+		               error  = math::Rational(
+			               1, LD::ipow<math::Unsigned>(10, 100));
+
+		while (LD::abs(result - last) > error) {
+			last   = result;
+			result = (result + src / result) / 2;
+		}
+
+		result.round(100);
+	});
+
+	std::vector<std::pair<std::string, math::Rational>> inputs {
+		{"2",       2},
+		{"10^50+1", math::Rational(math::Integer(
+			IntegerMath::pow(math::Unsigned(10),
+			                 IntegerMath::from_word(50)) + 1), 1)}
+	};
+
+	for (auto & input : inputs) {
+		for (size_t digits = 100; digits <= 100000; digits *= 10) {
+			unsigned long iterations = digits <= 10000 ? 5 : 1;
+
+			std::cout << "sqrt(" << input.first << "), " << digits
+			          << " digits" << std::endl;
+
+			bench("isqrt", iterations, [&]() {
+				Irrational::sqrt_digits(digits, input.second);
+			});
+		}
+	}
+}
+
+/**
+ * Precisions someone might go through while looking at constants, mostly
+ * going back down to fewer digits, or a few more than before
+ */
+std::vector<size_t> constant_sequence {
+	10000, 5000, 10000, 1000, 10010, 100, 2000, 10000, 50, 9000
+};
+
+/**
+ * Pi, e, the golden ratio and sqrt(2) with
+ * [[BasicRationalCalculator::irrational_cache]] turned off vs. on, over
+ * [[constant_sequence]].
+ */
+void bench_constants() {
+	for (unsigned long limit : {0ul, 16ul * 1024 * 1024}) {
+		BenchCalculator calc;
+
+		calc.irrational_cache.set_limit(limit);
+
+		std::cout << (limit ? "cached" : "uncached") << std::endl;
+
+		bench("pi", 1, [&]() {
+			for (size_t digits : constant_sequence) {
+				calc.irrational_cache.pi_digits(digits);
+			}
+		});
+
+		bench("e", 1, [&]() {
+			for (size_t digits : constant_sequence) {
+				calc.irrational_cache.e_digits(digits);
+			}
+		});
+
+		bench("golden", 1, [&]() {
+			for (size_t digits : constant_sequence) {
+				calc.irrational_cache.golden_digits(digits);
+			}
+		});
+
+		bench("sqrt(2)", 1, [&]() {
+			for (size_t digits : constant_sequence) {
+				calc.irrational_cache.sqrt_digits(digits, 2);
+			}
+		});
+
+		std::cout << "  " << calc.irrational_cache.hits << " hits, "
+		          << calc.irrational_cache.misses << " misses" << std::endl;
+	}
+}
+
+std::map<std::string, std::function<void()>> benchmarks {
+	{"bytecode",   bench_bytecode},
+	{"errors",     bench_errors},
+	{"validate",   bench_validate},
+	{"power",      bench_power},
+	{"factorial",  bench_factorial},
+	{"factorials", bench_factorials},
+	{"memo",       bench_memo},
+	{"hybrid",     bench_hybrid},
+	{"flatten",    bench_flatten},
+	{"threads",    bench_threads},
+	{"tree",       bench_tree},
+	{"decimal",    bench_decimal},
+	{"precision",  bench_precision},
+	{"pi",         bench_pi},
+	{"e",          bench_e},
+	{"golden",     bench_golden},
+	{"sqrt",       bench_sqrt},
+	{"constants",  bench_constants}
+};
+
+int main(int argc, char ** argv) {
+	std::vector<std::string> names(argv + 1, argv + argc);
+
+	if (names.empty()) {
+		for (auto & benchmark : benchmarks) {
+			names.push_back(benchmark.first);
+		}
+	}
+
+	for (const std::string & name : names) {
+		auto found = benchmarks.find(name);
+
+		if (found == benchmarks.end()) {
+			std::cerr << "Unknown benchmark " << name << std::endl;
+
+			return 1;
+		}
+
+		std::cout << "== " << name << " ==" << std::endl;
+		found->second();
+		std::cout << std::endl;
+	}
+}
@@ -61,24 +61,38 @@ class EmscriptenRationalCalculator : public RationalCalculator {
 	emscripten::val get_vars() {
 		emscripten::val obj = emscripten::val::object();
 
-		auto end = variables.end();
-
-		for (auto it = variables.begin(); it != end; it++) {
-			obj.set(it->first, to_string(it->second));
+		for (auto & slot : variables.get_slots()) {
+			if (variables.is_defined(slot.second)) {
+				obj.set(slot.first, to_string(variables.get(slot.second)));
+			}
 		}
 
 		return obj;
 	}
 
+	/**
+	 * Errors are thrown straight to JavaScript from the result, so nothing
+	 * has to be thrown and caught on the C++ side
+	 */
 	std::wstring _execute_ast(const CalcASTElem & ast) {
 		EXC_WRAPPER(
-			return to_string(execute_ast(ast, false, true));
+			CalcResult<math::Rational> result = try_evaluate(ast, false, true);
+
+			if (!result.ok()) {
+				emscripten::val(result.get_error().exception()).throw_();
+			}
+
+			return to_string(result.get());
 		)
 	}
 
 	bool valid_ast(const CalcASTElem & ast) {
 		EXC_WRAPPER(
-			execute_ast(ast, true);
+			CalcResult<bool> result = try_validate(ast);
+
+			if (!result.ok()) {
+				emscripten::val(result.get_error().exception()).throw_();
+			}
 
 			return true;
 		)
@@ -124,7 +138,8 @@ EMSCRIPTEN_BINDINGS(tokens) {
 	emscripten::value_object<Token>("Token")
 		.field("type", & Token::type)
 		.field("data", & Token::data)
-		.field("pos", & Token::pos);
+		.field("pos", & Token::pos)
+		.field("op", & Token::op);
 
 	emscripten::register_vector<Token>("vector<Token>");
 }